@@ -1,7 +1,9 @@
 # Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 # SPDX-License-Identifier: Apache-2.0
 
-"""Module wrapper implementing ZeRO-1 in an FSDP style interface"""
+"""Module wrapper implementing ZeRO in an FSDP style interface"""
+import functools
+
 import torch
 import torch.nn as nn
 import torch.nn.functional as F
@@ -9,18 +11,41 @@ import torch.nn.functional as F
 from raf import distributed as dist
 
 import ratex.optimizer as optim
-from ratex.core.lazy_model import all_gather, all_reduce, REDUCE_SUM
+from ratex.core.lazy_model import (
+    all_gather,
+    all_reduce,
+    bucket_tensors,
+    get_bucket_bytes,
+    reduce_scatter,
+    REDUCE_SUM,
+)
 
 
 class RatexFullyShardedDataParallel(nn.Module):
     r"""
-    FSDP ZeRO-1 wrapper
+    FSDP ZeRO wrapper
     Args:
       module (nn.Module): The module to be wrapped and sharded
       optimizer (torch.optim.Optimizer): The constructor to be used for initializing the optimizer
         Default: ratex.Optimizer.SGD
       optimizer_config (dict): Arguments to be passed into the optimizer constructor
         Default: None - Corresponds to an empty dictionary
+      sharding_stage (int): What is sharded across the ranks, like the ZeRO stages
+        1 - The optimizer states. The full gradients are all-reduced, and the updated
+            parameters are all-gathered one by one.
+        2 - The gradients too. The gradients are reduce-scattered in flattened buckets directly
+            into the shard of each rank, and the updated parameters are all-gathered in buckets.
+        3 - The parameters too. The wrapped module is split into units, the submodules that
+            directly own parameters. The full parameters of a unit are gathered in buckets one
+            unit ahead of its forward pass, and released after it. The backward pass gathers
+            them again one unit ahead in reverse order, and releases them once the gradients of
+            the unit are computed, so that only a few units are full at any point of the step.
+            Note that a module scripted with ratex.jit.script is a single unit, whose backward
+            closure keeps its full parameters until the backward pass.
+        Default: 1
+      bucket_size_mb (float): The target size of the buckets of the collectives of the sharding
+        stages 2 and 3, in MBs
+        Default: None - Corresponds to RATEX_GRAD_BUCKET_SIZE, or 25 if not set
     """
 
     def __init__(
@@ -28,19 +53,37 @@ class RatexFullyShardedDataParallel(nn.Module):
         module: nn.Module,
         optimizer: torch.optim.Optimizer = optim.SGD,
         optimizer_config: dict = None,
+        sharding_stage: int = 1,
+        bucket_size_mb: float = None,
     ):
         super().__init__()
+        if sharding_stage not in (1, 2, 3):
+            raise ValueError("Invalid sharding stage: {}".format(sharding_stage))
         comm = dist.get_communicator()
         self.rank = comm.rank
         self.world_size = comm.size
+        self.sharding_stage = sharding_stage
         self.module = module
         self.params = list(self.module.parameters())
+        self.param_shapes = [param.shape for param in self.params]
 
         # Shard parameters for use in optimizer
         self.sharded_params = []
         self._shard_parameters()
+        # The collectives of the sharding stages 2 and 3 are bucketed by parameter indices
+        self.bucket_bytes = get_bucket_bytes(bucket_size_mb)
+        self.buckets = self._bucket_parameters(range(len(self.params)))
         # Optimizer initialization
         self.optimizer = optimizer(self.sharded_parameters(), **optimizer_config or {})
+        # The parameter indices of each unit of the sharding stage 3, in the order of the modules
+        self.units = []
+        # The indices of the parameters whose full copy is gathered
+        self.gathered = set()
+        # The indices of the parameters of each unit whose gradients are not computed yet
+        self.pending_grads = {}
+        if self.sharding_stage == 3:
+            self._register_unit_hooks()
+            self._release_parameters()
 
     def _shard_parameters(self):
         """
@@ -50,10 +93,41 @@ class RatexFullyShardedDataParallel(nn.Module):
         Returns: None
         """
         for param in self.params:
-            shard_data = self._shard_tensor(param.data)
+            # Copied so that the shard does not keep the full parameter alive
+            shard_data = self._shard_tensor(param.data).clone()
             shard = nn.Parameter(shard_data, requires_grad=param.requires_grad)
             self.sharded_params.append(shard)
 
+    def _bucket_parameters(self, indices):
+        """
+        Group parameters into the buckets of their collectives
+        Args:
+          indices (list): The indices of the parameters to be bucketed, in order
+        Returns:
+          The list of buckets, each a list of parameter indices
+        """
+        shards = {id(self.sharded_params[index]): index for index in indices}
+        return [
+            [shards[id(shard)] for shard in bucket]
+            for bucket in bucket_tensors(
+                [self.sharded_params[index] for index in indices], self.bucket_bytes
+            )
+        ]
+
+    def _pad_tensor(self, tensor: torch.Tensor):
+        """
+        Pad the first dimension of the input tensor to a multiple of the number of ranks
+        Args:
+          tensor (torch.Tensor): tensor to be padded
+        Returns:
+          The padded tensor, which has the same shard size on every rank
+        """
+        if tensor.size()[0] % self.world_size != 0:
+            padding = [0] * (len(tensor.size()) * 2)
+            padding[-1] = self.world_size - (tensor.size()[0] % self.world_size)
+            tensor = F.pad(tensor, tuple(padding))
+        return tensor
+
     def _shard_tensor(self, tensor: torch.Tensor):
         """
         Get the shard of the input tensor that is associated with this rank
@@ -63,11 +137,7 @@ class RatexFullyShardedDataParallel(nn.Module):
         Returns:
           A tensor that corresponds to the respective shard of this rank
         """
-        if self.rank == self.world_size - 1 and tensor.size()[0] % self.world_size != 0:
-            padding = [0] * (len(tensor.size()) * 2)
-            padding[-1] = self.world_size - (tensor.size()[0] % self.world_size)
-            tensor = F.pad(tensor, tuple(padding))
-        tensor = tensor.chunk(self.world_size)[self.rank]
+        tensor = self._pad_tensor(tensor).chunk(self.world_size)[self.rank]
         return tensor
 
     def sharded_parameters(self):
@@ -78,6 +148,82 @@ class RatexFullyShardedDataParallel(nn.Module):
         """
         yield from self.sharded_params
 
+    def _register_unit_hooks(self):
+        """
+        Split the wrapped module into units, and register the hooks that gather and release the
+        full parameters of each unit around its forward and backward passes
+        Args: None
+        Returns: None
+        """
+        param_indices = {id(param): index for index, param in enumerate(self.params)}
+        for module in self.module.modules():
+            unit = [param_indices[id(param)] for param in module.parameters(recurse=False)]
+            if not unit:
+                continue
+            module.register_forward_pre_hook(functools.partial(self._pre_forward, len(self.units)))
+            module.register_forward_hook(functools.partial(self._post_forward, len(self.units)))
+            self.units.append(unit)
+        for index, param in enumerate(self.params):
+            if param.requires_grad:
+                param.register_hook(functools.partial(self._post_backward, index))
+
+    # pylint: disable=unused-argument
+    def _pre_forward(self, unit, module, args):
+        """
+        Gather the full parameters of a unit before its forward pass, and prefetch the ones of
+        the next unit
+        """
+        self._gather_unit(unit)
+        if unit + 1 < len(self.units):
+            self._gather_unit(unit + 1)
+
+    def _post_forward(self, unit, module, args, output):
+        """
+        Release the full parameters of a unit after its forward pass, and hook its outputs to
+        gather them again before its backward pass
+        """
+        self._release_parameters(self.units[unit])
+        if not torch.is_grad_enabled():
+            return
+        outputs = output if isinstance(output, (list, tuple)) else [output]
+        for tensor in outputs:
+            if isinstance(tensor, torch.Tensor) and tensor.requires_grad:
+                tensor.register_hook(functools.partial(self._pre_backward, unit))
+
+    def _pre_backward(self, unit, grad):
+        """
+        Gather the full parameters of a unit before its backward pass, and prefetch the ones of
+        the previous unit, which is the next one to run backward
+        """
+        if unit not in self.pending_grads:
+            self.pending_grads[unit] = {
+                index for index in self.units[unit] if self.params[index].requires_grad
+            }
+        self._gather_unit(unit)
+        if unit > 0:
+            self._gather_unit(unit - 1)
+
+    def _post_backward(self, index, grad):
+        """
+        Release the full parameters of the units whose gradients are all computed
+        """
+        for unit, pending in list(self.pending_grads.items()):
+            pending.discard(index)
+            if not pending:
+                del self.pending_grads[unit]
+                self._release_parameters(self.units[unit])
+
+    # pylint: enable=unused-argument
+    def _gather_unit(self, unit):
+        """
+        All gather the full parameters of a unit that are released, in buckets
+        Args:
+          unit (int): The index of the unit
+        Returns: None
+        """
+        indices = [index for index in self.units[unit] if index not in self.gathered]
+        self._gather_buckets(self._bucket_parameters(indices))
+
     def forward(self, *args, **kwargs):
         """
         Calculate the output of the model using the wrapped module
@@ -88,6 +234,72 @@ class RatexFullyShardedDataParallel(nn.Module):
         """
         return self.module(*args, **kwargs)
 
+    def gather_parameters(self):
+        """
+        All gather the parameter shards of the ranks in buckets, and assign them to the full
+        parameters
+        Args: None
+        Returns: None
+        """
+        self._gather_buckets(self.buckets)
+
+    def _gather_buckets(self, buckets):
+        """
+        All gather the parameter shards of the ranks in the given buckets of parameter indices
+        Args:
+          buckets (list): The buckets to be gathered
+        Returns: None
+        """
+        for bucket in buckets:
+            shards = [self.sharded_params[index].data.reshape(-1) for index in bucket]
+            flat = torch.cat(shards) if len(shards) > 1 else shards[0]
+            # Each row holds the shards of a rank
+            gathered = all_gather(flat, dim=0).reshape(self.world_size, -1)
+            blocks = gathered.split([shard.numel() for shard in shards], dim=1)
+            for index, block in zip(bucket, blocks):
+                shape = self.param_shapes[index]
+                param = block.reshape((-1,) + tuple(shape[1:]))[: shape[0]]
+                self.params[index].data = param
+                self.gathered.add(index)
+
+    def _release_parameters(self, indices=None):
+        """
+        Release the full parameters, which are only gathered around the passes of their units
+        with the sharding stage 3
+        Args:
+          indices (list): The indices of the parameters to be released
+            Default: None - Corresponds to all the parameters
+        Returns: None
+        """
+        for index in range(len(self.params)) if indices is None else indices:
+            param = self.params[index]
+            param.data = param.data.new_empty((0,) + tuple(self.param_shapes[index][1:]))
+            self.gathered.discard(index)
+
+    def _reduce_scatter_gradients(self):
+        """
+        Reduce scatter the full gradients across the ranks in buckets, and assign the gradient
+        shards to the respective parameter shards
+        Args: None
+        Returns: None
+        """
+        for bucket in self.buckets:
+            bucket = [index for index in bucket if self.params[index].grad is not None]
+            if not bucket:
+                continue
+            # The i-th row of a block is the shard of the i-th rank
+            blocks = [
+                self._pad_tensor(self.params[index].grad).reshape(self.world_size, -1)
+                for index in bucket
+            ]
+            flat = torch.cat(blocks, dim=1) if len(blocks) > 1 else blocks[0]
+            reduced = reduce_scatter(flat.reshape(-1), REDUCE_SUM) * (1.0 / self.world_size)
+            for index, grad in zip(bucket, reduced.split([block.size(1) for block in blocks])):
+                shard = self.sharded_params[index]
+                shard.grad = grad.view(shard.shape)
+                # The full gradient is no longer needed
+                self.params[index].grad = None
+
     def step(self, *args, **kwargs):
         """
         Step the optimizer and update parameter weights
@@ -96,18 +308,28 @@ class RatexFullyShardedDataParallel(nn.Module):
         Returns:
           The calculated loss from the backwards pass
         """
-        # Reduce full gradients across ranks
-        # Assign gradient shards to the respective parameter shards
-        for param, shard in zip(self.params, self.sharded_params):
-            if param.grad is not None:
-                all_reduce(REDUCE_SUM, [param.grad], scale=1.0 / self.world_size)
-                shard.grad = self._shard_tensor(param.grad)
+        if self.sharding_stage == 1:
+            # Reduce full gradients across ranks
+            # Assign gradient shards to the respective parameter shards
+            for param, shard in zip(self.params, self.sharded_params):
+                if param.grad is not None:
+                    all_reduce(REDUCE_SUM, [param.grad], scale=1.0 / self.world_size)
+                    shard.grad = self._shard_tensor(param.grad)
+        else:
+            self._reduce_scatter_gradients()
 
         # Step the wrapped optimizer
         loss = self.optimizer.step(*args, **kwargs)
 
-        # All gather the new weights across the ranks and assign them to the full parameters
-        for param, shard in zip(self.params, self.sharded_params):
-            param.data = all_gather(shard.data, dim=0)[: param.data.shape[0]]
+        if self.sharding_stage == 1:
+            # All gather the new weights across the ranks and assign them to the full parameters
+            for param, shard in zip(self.params, self.sharded_params):
+                param.data = all_gather(shard.data, dim=0)[: param.data.shape[0]]
+        elif self.sharding_stage == 2:
+            self.gather_parameters()
+        else:
+            # The parameters of the units without gradients are still gathered
+            self.pending_grads.clear()
+            self._release_parameters()
 
         return loss
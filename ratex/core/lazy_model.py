@@ -3,11 +3,16 @@
 
 """Redefine the interfaces similar to lazy_model.py in lazy_tensor_core."""
 # pylint: disable=invalid-name, protected-access, c-extension-no-member, too-many-nested-blocks
+import os
+
 import torch
 
 from raf import distributed as dist
 import _RATEXC
 
+from ratex.core import shm_collectives
+from ratex.utils.utils import ltc_counter
+
 REDUCE_SUM = "sum"
 REDUCE_MUL = "mul"
 REDUCE_AND = "and"
@@ -15,6 +20,9 @@ REDUCE_OR = "or"
 REDUCE_MIN = "min"
 REDUCE_MAX = "max"
 
+if shm_collectives.is_enabled():
+    shm_collectives.init()
+
 
 def all_reduce(reduce_type, inputs, scale=1.0, groups=None):
     """Performs an inplace reduce operation on the input tensor(s).
@@ -37,6 +45,8 @@ def all_reduce(reduce_type, inputs, scale=1.0, groups=None):
       this function performs an inplace all-reduce op on the input tensors, and
       returns the list/tuple itself.
     """
+    if shm_collectives.is_enabled():
+        return shm_collectives.all_reduce(reduce_type, inputs, scale, groups)
     comm = dist.get_communicator()
     if groups is None:
         groups = [list(range(0, comm.size))]
@@ -69,9 +79,15 @@ def all_gather(value, dim=0, groups=None, output=None):
       A tensor which has, in the ``dim`` dimension, all the values from the
       participating replicas.
     """
-    comm = dist.get_communicator()
     if dim < 0:
         dim = value.dim() + dim
+    if shm_collectives.is_enabled():
+        result = shm_collectives.all_gather(value, dim, groups)
+        if output is not None:
+            output.copy_(result)
+            return output
+        return result
+    comm = dist.get_communicator()
     token = _RATEXC._raf_create_token(value.device.type)
 
     if groups is None:
@@ -100,6 +116,8 @@ def reduce_scatter(value, reduce_type="sum", groups=None):
     Returns:
       A single `torch.Tensor` holding the reduce-scattered value (across the replicas).
     """
+    if shm_collectives.is_enabled():
+        return shm_collectives.reduce_scatter(value, reduce_type, groups)
     comm = dist.get_communicator()
     token = _RATEXC._raf_create_token(value.device.type)
 
@@ -110,9 +128,102 @@ def reduce_scatter(value, reduce_type="sum", groups=None):
     return result[0]
 
 
-def reduce_gradients(optimizer, groups=None):
+def all_to_all(value, split_dimension, concat_dimension, split_count=None, groups=None):
+    """Performs an all-to-all operation on the input tensor.
+    Args:
+      value (torch.Tensor): The input tensor.
+      split_dimension (int): The dimension split in `split_count` blocks, the i-th of which is
+        sent to the i-th replica of the group.
+      concat_dimension (int): The dimension along which the received blocks are concatenated.
+      split_count (int, optional): The number of replicas of a group. If `None` it is the size
+        of the replica groups.
+      groups (list, optional): A list of list, representing the replica groups for
+        the `all_to_all()` operation. Example: `[[0, 1, 2, 3], [4, 5, 6, 7]]`
+          defines two groups, one with the `[0, 1, 2, 3]` replicas and one with
+          the `[4, 5, 6, 7]` replicas. If `None` there will be only one group with
+          all the replicas in it.
+    Returns:
+      A single `torch.Tensor` holding the exchanged blocks.
+    """
+    if split_dimension < 0:
+        split_dimension = value.dim() + split_dimension
+    if concat_dimension < 0:
+        concat_dimension = value.dim() + concat_dimension
+    if shm_collectives.is_enabled():
+        return shm_collectives.all_to_all(
+            value, split_dimension, concat_dimension, split_count, groups
+        )
+    comm = dist.get_communicator()
+    token = _RATEXC._raf_create_token(value.device.type)
+
+    if groups is None:
+        groups = [list(range(0, comm.size))]
+    if split_count is None:
+        split_count = len(groups[0])
+
+    result = _RATEXC._ltc_all_to_all(
+        value, token, split_dimension, concat_dimension, split_count, groups
+    )
+    return result[0]
+
+
+def collective_permute(value, pairs):
+    """Performs a collective permute operation on the input tensor.
+    Args:
+      value (torch.Tensor): The input tensor.
+      pairs (list): A list of (source, target) replica pairs. Example: `[[0, 1], [1, 2], [2, 0]]`
+        sends the tensor of replica 0 to replica 1, replica 1 to replica 2, and replica 2 to
+        replica 0. A replica is the source and the target of at most one pair each.
+    Returns:
+      A single `torch.Tensor` holding the value of the source replica, or zeros if this replica
+      is not the target of a pair.
+    """
+    if shm_collectives.is_enabled():
+        return shm_collectives.collective_permute(value, pairs)
+    token = _RATEXC._raf_create_token(value.device.type)
+    result = _RATEXC._ltc_collective_permute(
+        value, token, [list(pair) for pair in pairs], dist.get_communicator().rank
+    )
+    return result[0]
+
+
+def bucket_tensors(tensors, bucket_bytes):
+    """Groups the tensors by dtype and device into buckets of up to `bucket_bytes` bytes, in
+    order. A tensor larger than a bucket gets its own bucket, and so do all the tensors if
+    `bucket_bytes` is 0.
+
+    Returns:
+      The list of buckets, each a list of tensors.
+    """
+    buckets = []
+    open_buckets = {}
+    for tensor in tensors:
+        key = (tensor.dtype, tensor.device)
+        nbytes = tensor.numel() * tensor.element_size()
+        bucket = open_buckets.get(key)
+        if bucket is None or bucket[1] + nbytes > bucket_bytes:
+            bucket = [[], 0]
+            buckets.append(bucket[0])
+            open_buckets[key] = bucket
+        bucket[0].append(tensor)
+        bucket[1] += nbytes
+    return buckets
+
+
+def get_bucket_bytes(bucket_size_mb=None):
+    """Returns the target size of the buckets of the collectives in bytes, which is
+    `bucket_size_mb` if set, or RATEX_GRAD_BUCKET_SIZE in MBs (25 by default)."""
+    if bucket_size_mb is None:
+        bucket_size_mb = float(os.environ.get("RATEX_GRAD_BUCKET_SIZE", 25))
+    return int(bucket_size_mb * (1 << 20))
+
+
+def reduce_gradients(optimizer, groups=None, bucket_size_mb=None):
     """Reduces all the gradients handled by an optimizer.
 
+    The gradients are flattened into buckets of the same dtype, each reduced with a single
+    collective, and the reduced values are copied back into the gradients within the graph.
+
     Args:
       optimizer (:class:`torch.Optimizer`): The `torch.Optimizer` instance
         containing the gradients to be reduced.
@@ -121,13 +232,44 @@ def reduce_gradients(optimizer, groups=None):
           defines two groups, one with the `[0, 1, 2, 3]` replicas and one with
           the `[4, 5, 6, 7]` replicas. If `None` there will be only one group with
           all the replicas in it.
+      bucket_size_mb (float, optional): The target size of a bucket in MBs, where 0 reduces each
+        gradient on its own.
+        Default: RATEX_GRAD_BUCKET_SIZE, or 25 if not set.
     """
     comm = dist.get_communicator()
     world_size = comm.size
-    if world_size > 1:
-        for param_group in optimizer.__getstate__()["param_groups"]:
-            for group, params in param_group.items():
-                if group == "params":
-                    for p in params:
-                        if isinstance(p, torch.Tensor) and p.grad is not None:
-                            all_reduce(REDUCE_SUM, [p.grad], scale=1.0 / world_size, groups=groups)
+    if world_size <= 1:
+        return
+    grads = []
+    for param_group in optimizer.__getstate__()["param_groups"]:
+        for group, params in param_group.items():
+            if group == "params":
+                for p in params:
+                    if isinstance(p, torch.Tensor) and p.grad is not None:
+                        grads.append(p.grad)
+
+    buckets = bucket_tensors(grads, get_bucket_bytes(bucket_size_mb))
+    for bucket in buckets:
+        if len(bucket) == 1:
+            all_reduce(REDUCE_SUM, bucket, scale=1.0 / world_size, groups=groups)
+            continue
+        flat = torch.cat([grad.reshape(-1) for grad in bucket])
+        flat = all_reduce(REDUCE_SUM, flat, scale=1.0 / world_size, groups=groups)
+        for grad, reduced in zip(bucket, flat.split([grad.numel() for grad in bucket])):
+            grad.copy_(reduced.view_as(grad))
+    ltc_counter("ReduceGradientsCalls")
+    ltc_counter("ReduceGradientsCollectives", len(buckets))
+    ltc_counter("ReduceGradientsBytes", sum(grad.numel() * grad.element_size() for grad in grads))
+
+
+def get_executable_memory_info():
+    """Retrieves the estimated memory footprint of the live compiled executables.
+
+    Returns:
+      A list of dictionaries, one per executable, with `id`, `device`, `peak_bytes`
+      (peak working set of one execution), `param_bytes`, `constant_bytes`,
+      `workspace_bytes` (peak size of the intermediate and output tensors),
+      `memory_budget` (rematerialization budget in MBs, 0 if disabled) and
+      `recompute_ops` (operator calls added by rematerialization) keys.
+    """
+    return _RATEXC._raf_executable_memory_info()
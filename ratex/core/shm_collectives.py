@@ -0,0 +1,191 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Collectives of the processes of a single host through shared memory.
+
+With RATEX_COLLECTIVE_BACKEND=shm, the collectives of `ratex.core.lazy_model` are not lowered into
+the graphs, which would need the RAF communicators (MPI and NCCL). Instead, the input tensors are
+fetched to the host, reduced or exchanged through a POSIX shared memory segment, and copied back
+to their device. This lets the distributed code paths (e.g., `reduce_gradients`, ZeRO and FSDP)
+be tested with N processes on one host.
+
+Every collective is a host round trip: it runs the pending computation of its inputs, fetches them,
+and uploads its outputs as new device data, so it cuts the graph of the step in two. A step with N
+collectives runs N + 1 graphs with a device to host copy and a host to device copy in between. This
+backend only checks the numerical results of those code paths, not the graphs they trace, and it
+cannot be used to benchmark them: it is not a substitute for the RAF collectives.
+
+Each process reads its rank and the number of processes from RATEX_SHM_RANK and
+RATEX_SHM_WORLD_SIZE (LOCAL_RANK and LOCAL_WORLD_SIZE, as set by torchrun, otherwise), and the
+processes meet at the segment named after RATEX_SHM_NAME (their parent process ID by default).
+RATEX_SHM_SLOT_SIZE sets the staging memory per process in MBs (8 by default), and
+RATEX_SHM_TIMEOUT the seconds to wait for the other processes (300 by default).
+"""
+# pylint: disable=c-extension-no-member, protected-access
+import hashlib
+import os
+
+import torch
+
+from raf import distributed as dist
+import _RATEXC
+
+_COMMUNICATORS = {}
+
+
+def is_enabled():
+    """Returns whether the collectives run on the shared memory backend."""
+    return os.environ.get("RATEX_COLLECTIVE_BACKEND", "raf") == "shm"
+
+
+def get_rank():
+    return int(os.environ.get("RATEX_SHM_RANK", os.environ.get("LOCAL_RANK", 0)))
+
+
+def get_world_size():
+    return int(os.environ.get("RATEX_SHM_WORLD_SIZE", os.environ.get("LOCAL_WORLD_SIZE", 1)))
+
+
+def init():
+    """Sets the rank and the size of the RAF communicator, which the distributed modules read,
+    with a void communicator since the RAF collectives are not used."""
+    dist.set_default_communicator("void")
+    comm = dist.get_communicator()
+    comm.size = get_world_size()
+    comm.rank = get_rank()
+
+
+def _group_ranks(groups):
+    rank, world_size = get_rank(), get_world_size()
+    if not groups:
+        return tuple(range(world_size))
+    for group in groups:
+        if rank in group:
+            return tuple(group)
+    raise ValueError("Rank {} is not in the replica groups {}".format(rank, groups))
+
+
+def get_communicator(groups=None):
+    """Returns the communicator of the replica group of this process, which attaches to its
+    segment on first use. All the processes of the group must call it."""
+    ranks = _group_ranks(groups)
+    comm = _COMMUNICATORS.get(ranks)
+    if comm is None:
+        name = "/" + os.environ.get("RATEX_SHM_NAME", "ratex_{}".format(os.getppid()))
+        if ranks != tuple(range(get_world_size())):
+            name += "_" + hashlib.md5(str(ranks).encode()).hexdigest()[:16]
+        comm = _RATEXC.ShmCommunicator(
+            name,
+            ranks.index(get_rank()),
+            len(ranks),
+            slot_bytes=int(os.environ.get("RATEX_SHM_SLOT_SIZE", 8)) << 20,
+            timeout=float(os.environ.get("RATEX_SHM_TIMEOUT", 300)),
+        )
+        _COMMUNICATORS[ranks] = comm
+    return comm
+
+
+def _to_host(tensors):
+    """Fetches the lazy tensors to the host in bulk, running their pending computations. This
+    cuts the graph of the step, as the collective results are uploaded as new device data."""
+    lazy = [i for i, t in enumerate(tensors) if t.device.type == "lazy"]
+    results = [t.detach().contiguous() for t in tensors]
+    if lazy:
+        for i, result in zip(lazy, _RATEXC._ltc_get_cpu_tensors([tensors[i] for i in lazy])):
+            results[i] = result.contiguous()
+    return results
+
+
+def _scale(tensor, scale):
+    if scale == 1.0:
+        return
+    if tensor.is_floating_point():
+        tensor.mul_(scale)
+    else:
+        # Like the lowered all-reduce, divide the integers by the inverse of the scale.
+        tensor.copy_(torch.div(tensor, round(1.0 / scale), rounding_mode="trunc"))
+
+
+def all_reduce(reduce_type, inputs, scale=1.0, groups=None):
+    """The shared memory version of `ratex.core.lazy_model.all_reduce()`."""
+    comm = get_communicator(groups)
+    tensors = [inputs] if isinstance(inputs, torch.Tensor) else inputs
+    results = _to_host(tensors)
+    for result in results:
+        comm.all_reduce(result, reduce_type)
+        _scale(result, scale)
+    if isinstance(inputs, torch.Tensor):
+        return results[0].to(inputs.device)
+    for tensor, result in zip(inputs, results):
+        tensor.copy_(result)
+    return inputs
+
+
+def all_gather(value, dim=0, groups=None):
+    """The shared memory version of `ratex.core.lazy_model.all_gather()`."""
+    comm = get_communicator(groups)
+    host = _to_host([value])[0].movedim(dim, 0).contiguous()
+    result = host.new_empty((comm.size * host.size(0),) + tuple(host.shape[1:]))
+    comm.all_gather(host, result)
+    return result.movedim(0, dim).to(value.device)
+
+
+def reduce_scatter(value, reduce_type="sum", groups=None):
+    """The shared memory version of `ratex.core.lazy_model.reduce_scatter()`, which scatters the
+    first dimension."""
+    comm = get_communicator(groups)
+    host = _to_host([value])[0]
+    if host.size(0) % comm.size != 0:
+        raise ValueError(
+            "The first dimension {} is not divisible by {} ranks".format(host.size(0), comm.size)
+        )
+    result = host.new_empty((host.size(0) // comm.size,) + tuple(host.shape[1:]))
+    comm.reduce_scatter(host, result, "sum" if reduce_type == "avg" else reduce_type)
+    if reduce_type == "avg":
+        _scale(result, 1.0 / comm.size)
+    return result.to(value.device)
+
+
+def broadcast(value, root=0, groups=None):
+    """Returns the value of the root rank of the replica group on all its ranks."""
+    comm = get_communicator(groups)
+    host = _to_host([value])[0].clone()
+    comm.broadcast(host, root)
+    return host.to(value.device)
+
+
+def all_to_all(value, split_dim, concat_dim, split_count=None, groups=None):
+    """Splits the value in `size` blocks along `split_dim`, sends the i-th block to the i-th rank
+    of the replica group, and concatenates the received blocks along `concat_dim`. The segment
+    holds one block per rank, so `split_count` must be the size of the replica group."""
+    comm = get_communicator(groups)
+    if split_count is not None and split_count != comm.size:
+        raise ValueError(
+            "The split count {} must be the replica group size {}".format(split_count, comm.size)
+        )
+    host = _to_host([value])[0]
+    if host.size(split_dim) % comm.size != 0:
+        raise ValueError(
+            "The split dimension {} is not divisible by {} ranks".format(
+                host.size(split_dim), comm.size
+            )
+        )
+    blocks = torch.stack(host.chunk(comm.size, split_dim)).contiguous()
+    received = torch.empty_like(blocks)
+    comm.all_to_all(blocks, received)
+    return torch.cat(received.unbind(0), concat_dim).to(value.device)
+
+
+def collective_permute(value, pairs):
+    """Sends the value of each source rank of the (source, target) pairs to its target rank. The
+    ranks which are not the target of a pair receive zeros."""
+    comm = get_communicator()
+    rank = get_rank()
+    sources = [source for source, target in pairs if target == rank]
+    targets = [target for source, target in pairs if source == rank]
+    if len(sources) > 1 or len(targets) > 1:
+        raise ValueError("Rank {} is in more than one pair of {}".format(rank, pairs))
+    host = _to_host([value])[0]
+    result = torch.empty_like(host)
+    comm.permute(host, result, sources[0] if sources else -1, targets[0] if targets else -1)
+    return result.to(value.device)
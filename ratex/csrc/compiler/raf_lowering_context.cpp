@@ -5,13 +5,17 @@
 
 #include "ratex/csrc/compiler/raf_lowering_context.h"
 
+#include <algorithm>
+
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_replace.h"
 #include "absl/strings/string_view.h"
 #include "lazy_tensor_core/csrc/compiler/node_lowering.h"
 #include "lazy_tensor_core/csrc/lowering_context.h"
+#include "lazy_tensor_core/csrc/tensor_util.h"
 #include "lazy_tensors/computation_client/computation_client.h"
+#include "lazy_tensors/computation_client/metrics.h"
 #include "client/base_computation_client.h"
 
 #include "./utils.h"
@@ -20,6 +24,7 @@
 #include "raf/value.h"
 #include "raf/pass.h"
 #include "raf/binding.h"
+#include "raf/src/common/shape_utils.h"
 
 namespace torch_lazy_tensors {
 namespace compiler {
@@ -46,6 +51,88 @@ lazy_tensors::StatusOr<lazy_tensors::ProgramShape> GenericComputationRAF::GetPro
   return lazy_tensors::ProgramShape(parameters, parameter_names, result);
 }
 
+ConstantPool* ConstantPool::Get() {
+  static ConstantPool* pool = new ConstantPool();
+  return pool;
+}
+
+TensorValue ConstantPool::GetConstant(const lazy_tensors::Literal& literal,
+                                      const lazy_tensors::hash_t& hash, const Device& device) {
+  std::string device_str = device.ToString();
+  raf::Device raf_device = ToRAFDevice(device_str);
+  raf::DType dtype;
+  std::vector<int64_t> shape;
+  std::tie(shape, dtype) = ToRAFShape(literal.shape());
+  int64_t nbytes = raf::common::shape_utils::BytesCompactTensor(
+      Downcast<TensorType>(ToRAFType(literal.shape())).as<TensorTypeNode>());
+
+  absl::optional<lazy_tensors::hash_t> content_hash;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::shared_ptr<raf::memory_pool::Memory> buffer =
+        Find(literal, hash, device_str, &content_hash);
+    if (buffer != nullptr) {
+      LTC_COUNTER("ConstantPoolHit", 1);
+      LTC_COUNTER("ConstantPoolBytesShared", nbytes);
+      return TensorValue::Assemble(raf_device, dtype, shape, {}, buffer->data, buffer);
+    }
+  }
+
+  // The upload does not block the lowering of other constants.
+  LTC_COUNTER("ConstantPoolMiss", 1);
+  std::shared_ptr<raf::memory_pool::Memory> buffer =
+      raf::memory_pool::Memory::Alloc(raf_device, nbytes);
+  PopulateTensorBuffer(literal.value(), literal.shape(), buffer->data, nbytes, device);
+  if (!content_hash) {
+    content_hash = lazy_tensors::util::DataHash(literal.untyped_data(), literal.size_bytes());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Another thread may have uploaded the same constant in the meantime.
+  std::shared_ptr<raf::memory_pool::Memory> shared =
+      Find(literal, hash, device_str, &content_hash);
+  if (shared != nullptr) {
+    buffer = std::move(shared);
+  } else {
+    MaybePrune();
+    entries_.emplace(hash, Entry{device_str, literal.shape(), *content_hash, buffer});
+  }
+  return TensorValue::Assemble(raf_device, dtype, shape, {}, buffer->data, buffer);
+}
+
+std::shared_ptr<raf::memory_pool::Memory> ConstantPool::Find(
+    const lazy_tensors::Literal& literal, const lazy_tensors::hash_t& hash,
+    const std::string& device, absl::optional<lazy_tensors::hash_t>* content_hash) {
+  auto range = entries_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const Entry& entry = it->second;
+    if (entry.device != device || !(entry.shape == literal.shape())) {
+      continue;
+    }
+    if (!*content_hash) {
+      *content_hash = lazy_tensors::util::DataHash(literal.untyped_data(), literal.size_bytes());
+    }
+    if (entry.content_hash != **content_hash) {
+      continue;
+    }
+    std::shared_ptr<raf::memory_pool::Memory> buffer = entry.buffer.lock();
+    if (buffer != nullptr) {
+      return buffer;
+    }
+  }
+  return nullptr;
+}
+
+void ConstantPool::MaybePrune() {
+  if (entries_.size() < prune_size_) {
+    return;
+  }
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    it = it->second.buffer.expired() ? entries_.erase(it) : std::next(it);
+  }
+  prune_size_ = std::max<size_t>(64, 2 * entries_.size());
+}
+
 lazy_tensors::Shape RAFLoweringContext::GetResultShape(size_t index) const {
   Var root = GetResult(index);
   Expr body = InferType(ExtractBinding(root, GetParams()));
@@ -5,12 +5,19 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
+#include "absl/types/optional.h"
 #include "lazy_tensor_core/csrc/compiler/node_lowering.h"
 #include "lazy_tensor_core/csrc/lowering_context.h"
+#include "lazy_tensors/computation_client/util.h"
+#include "lazy_tensors/literal.h"
 
 #include "raf/ir.h"
+#include "raf/memory_pool.h"
 #include "raf/value.h"
 
 namespace torch_lazy_tensors {
@@ -50,6 +57,57 @@ class GenericComputationRAF : public lazy_tensors::GenericComputation {
   std::unordered_map<int64_t, int64_t> alias_;
 };
 
+/*!
+ * \brief A content-addressed pool of the constant tensors lowered to the devices, so that graphs
+ * lowering the same constant (e.g., an attention mask) share one device buffer. The pool does not
+ * own the buffers: they are reference counted by the lowered graphs and compiled executables
+ * embedding them, and released along with the last of these.
+ */
+class ConstantPool {
+ public:
+  static ConstantPool* Get();
+
+  /*!
+   * \brief Get the device tensor of a constant, which is uploaded unless an identical one is
+   * still alive on the device.
+   * \param literal The value of the constant.
+   * \param hash The hash of the literal.
+   * \param device The device to place the constant.
+   */
+  raf::value::TensorValue GetConstant(const lazy_tensors::Literal& literal,
+                                      const lazy_tensors::hash_t& hash, const Device& device);
+
+ private:
+  struct Entry {
+    std::string device;
+    lazy_tensors::Shape shape;
+    /*!
+     * \brief A hash of the bytes independent of the node hash, telling apart the constants with
+     * colliding node hashes without keeping their host values.
+     */
+    lazy_tensors::hash_t content_hash;
+    std::weak_ptr<raf::memory_pool::Memory> buffer;
+  };
+
+  /*!
+   * \brief Find the live buffer of a constant. The content hash of the literal is computed at the
+   * first entry matching its node hash. Must be called with mutex_ held.
+   */
+  std::shared_ptr<raf::memory_pool::Memory> Find(
+      const lazy_tensors::Literal& literal, const lazy_tensors::hash_t& hash,
+      const std::string& device, absl::optional<lazy_tensors::hash_t>* content_hash);
+
+  /*!
+   * \brief Drop the entries whose buffer has been released once the pool doubled since the last
+   * pruning, so that the cost is amortized over the insertions. Must be called with mutex_ held.
+   */
+  void MaybePrune();
+
+  std::mutex mutex_;
+  std::unordered_multimap<lazy_tensors::hash_t, Entry, lazy_tensors::util::HashReducer> entries_;
+  size_t prune_size_ = 64;
+};
+
 class RAFLoweringContext : public ir::LoweringContext {
  public:
   RAFLoweringContext(const std::string& name, Device device) : ir::LoweringContext(name, device) {
@@ -14,6 +14,7 @@
 #include "lazy_tensor_core/csrc/ops/all.h"
 #include "lazy_tensor_core/csrc/ops/all_gather.h"
 #include "lazy_tensor_core/csrc/ops/all_reduce.h"
+#include "lazy_tensor_core/csrc/ops/all_to_all.h"
 #include "lazy_tensor_core/csrc/ops/amp_foreach_non_finite_check_and_unscale.h"
 #include "lazy_tensor_core/csrc/ops/amp_update_scale.h"
 #include "lazy_tensor_core/csrc/ops/any.h"
@@ -29,6 +30,7 @@
 #include "lazy_tensor_core/csrc/ops/cast.h"
 #include "lazy_tensor_core/csrc/ops/cat.h"
 #include "lazy_tensor_core/csrc/ops/cholesky.h"
+#include "lazy_tensor_core/csrc/ops/collective_permute.h"
 #include "lazy_tensor_core/csrc/ops/constant.h"
 #include "lazy_tensor_core/csrc/ops/constant_pad_nd.h"
 #include "lazy_tensor_core/csrc/ops/convolution_backward_overrideable.h"
@@ -139,6 +141,7 @@
 #include "raf/ir_ext.h"
 #include "raf/value.h"
 #include "raf/binding.h"
+#include "raf/communicator.h"
 #include "raf/pass.h"
 #include "raf/src/op/regs/schema2value.h"
 #include "raf/src/common/shape_utils.h"
@@ -241,6 +244,8 @@ class RAFNodeLowering : public NodeLowering {
   DECLARE_OP2(AllReduce);
   DECLARE_OP2(AllGather);
   DECLARE_OP2(ReduceScatter);
+  DECLARE_OP2(AllToAll);
+  DECLARE_OP2(CollectivePermute);
   DECLARE_OP2(MaxInDim);
   DECLARE_OP2(ArgMax);
   DECLARE_OP2(Embedding);
@@ -277,6 +282,8 @@ class RAFNodeLowering : public NodeLowering {
   lazy_tensors::Shape InferAllReduce(const ir::ops::AllReduce* node);
   lazy_tensors::Shape InferAllGather(const ir::ops::AllGather* node);
   lazy_tensors::Shape InferReduceScatter(const ir::ops::ReduceScatter* node);
+  lazy_tensors::Shape InferAllToAll(const ir::ops::AllToAll* node);
+  lazy_tensors::Shape InferCollectivePermute(const ir::ops::CollectivePermute* node);
   lazy_tensors::Shape InferMaxInDim(const ir::ops::MaxInDim* node);
   lazy_tensors::Shape InferArgMax(const ir::ops::ArgMax* node);
   lazy_tensors::Shape InferConvolutionOverrideable(const ir::ops::ConvolutionOverrideable* node);
@@ -413,6 +420,13 @@ Var RAFNodeLowering::LowerToRAF(const ir::Node* node) {
         return LowerReduceScatter(
             ir::NodeCast<ir::ops::ReduceScatter>(node, *ir::ops::ltc_reduce_scatter));
       }
+      if (node->op() == *ir::ops::ltc_all_to_all) {
+        return LowerAllToAll(ir::NodeCast<ir::ops::AllToAll>(node, *ir::ops::ltc_all_to_all));
+      }
+      if (node->op() == *ir::ops::ltc_collective_permute) {
+        return LowerCollectivePermute(
+            ir::NodeCast<ir::ops::CollectivePermute>(node, *ir::ops::ltc_collective_permute));
+      }
       if (node->op() == *ir::ops::raf_dropout_backward) {
         return LowerDropoutBackward(
             ir::NodeCast<ir::ops::DropoutBackward>(node, *ir::ops::raf_dropout_backward));
@@ -1113,17 +1127,9 @@ Var RAFNodeLowering::LowerConstant(const ir::ops::Constant* node) {
   // TODO(@hzfan): unify LowerConstant for raf/Sunda, raf/CPU, raf/GPU
   // TODO(@hzfan): embed NeuronTensor into constants directly
   LTC_CHECK_EQ(node->num_outputs(), 1);
-  auto device = GetCurrentDevice();
-  raf::Device raf_device = ToRAFDevice(device.ToString());
-  int64_t nbytes = raf::common::shape_utils::BytesCompactTensor(
-      Downcast<TensorType>(ToRAFType(node->value().shape())).as<TensorTypeNode>());
-  auto buffer = memory_pool::Memory::Alloc(raf_device, nbytes);
-  DType dtype;
-  std::vector<int64_t> shape;
-  std::tie(shape, dtype) = ToRAFShape(node->value().shape());
-  PopulateTensorBuffer(node->value().value(), node->value().shape(), buffer->data, nbytes,
-                       Device(device));
-  auto value = TensorValue::Assemble(raf_device, dtype, shape, {}, buffer->data, buffer);
+  // Identical constants of different graphs share the device buffer.
+  auto value =
+      ConstantPool::Get()->GetConstant(node->value(), node->node_hash(), GetCurrentDevice());
   return BindSymbol(MakeConstant(value));
 }
 
@@ -1407,6 +1413,145 @@ Var RAFNodeLowering::LowerReduceScatter(const ir::ops::ReduceScatter* node) {
   return BuildReduceScatter(ops, node);
 }
 
+Var BuildAllToAll(const std::vector<Var>& ops, const ir::ops::AllToAll* node) {
+  LTC_CHECK_EQ(ops.size(), 2U);
+  // The last element in the operands is token
+  Var token = ops.back();
+  Var x = ops[0];
+  const lazy_tensors::Shape& shape = node->operand(0).shape();
+  int64_t rank = shape.rank();
+  int64_t split_dim = node->split_dimension();
+  int64_t concat_dim = node->concat_dimension();
+  int64_t split_count = node->split_count();
+  LTC_CHECK_EQ(shape.dimensions(split_dim) % split_count, 0)
+      << "The split dimension " << shape.dimensions(split_dim) << " is not divisible by "
+      << split_count;
+  for (const auto& group : node->groups()) {
+    LTC_CHECK_EQ(static_cast<int64_t>(group.size()), split_count);
+  }
+  // raf.op._all_to_all sends the i-th block of the first axis to the i-th rank, so the split
+  // dimension is split into a leading axis of split_count blocks.
+  std::vector<int64_t> blocks_shape;
+  std::vector<int64_t> axes = {split_dim};
+  for (int64_t i = 0; i < rank; ++i) {
+    if (i == split_dim) {
+      blocks_shape.push_back(split_count);
+      blocks_shape.push_back(shape.dimensions(i) / split_count);
+    } else {
+      blocks_shape.push_back(shape.dimensions(i));
+    }
+    axes.push_back(i < split_dim ? i : i + 1);
+  }
+  Expr reverse = MakeConstant(Bool(false));
+  x = BindSymbol(
+      raf::ir::Call(Op::Get("raf.op.reshape"), {x, MakeConstant(TupleInt(blocks_shape)), reverse}));
+  if (split_dim != 0) {
+    x = BindSymbol(raf::ir::Call(Op::Get("raf.op.transpose"), {x, MakeConstant(TupleInt(axes))}));
+  }
+  Expr rank_list = MakeConstant(ConvertReplicaGroupsToValue(node->groups()));
+  Var all_to_all_in = BindSymbol(raf::ir::Tuple(Array<Expr>({x})));
+  Var ret = BindSymbol(raf::ir::Call(Op::Get("raf.op._all_to_all"), {all_to_all_in, rank_list}));
+  // The received blocks are concatenated by moving their axis right before the concat dimension
+  // and merging the two.
+  std::vector<int64_t> result_shape;
+  axes.clear();
+  for (int64_t i = 0; i < rank; ++i) {
+    if (i == concat_dim) {
+      axes.push_back(0);
+    }
+    axes.push_back(i + 1);
+    int64_t dim = i == split_dim ? shape.dimensions(i) / split_count : shape.dimensions(i);
+    result_shape.push_back(i == concat_dim ? dim * split_count : dim);
+  }
+  if (concat_dim != 0) {
+    ret = BindSymbol(
+        raf::ir::Call(Op::Get("raf.op.transpose"), {ret, MakeConstant(TupleInt(axes))}));
+  }
+  ret = BindSymbol(raf::ir::Call(Op::Get("raf.op.reshape"),
+                                 {ret, MakeConstant(TupleInt(result_shape)), reverse}));
+  return BindSymbol(raf::ir::Tuple(Array<Expr>({ret, token})));
+}
+
+Var RAFNodeLowering::LowerAllToAll(const ir::ops::AllToAll* node) {
+  LTC_CHECK_EQ(node->num_outputs(), 2);
+  std::vector<Var> ops;
+  for (const auto& op : node->operands()) ops.push_back(loctx()->GetOutputOp(op));
+  return BuildAllToAll(ops, node);
+}
+
+Var BuildCollectivePermute(const std::vector<Var>& ops, const ir::ops::CollectivePermute* node) {
+  using tvm::runtime::DLDataType2String;
+  LTC_CHECK_EQ(ops.size(), 2U);
+  // The last element in the operands is token
+  Var token = ops.back();
+  Var x = ops[0];
+  // The pairs are resolved to the peers of the rank the node was traced on.
+  int64_t rank = node->rank();
+  int64_t source = -1;
+  int64_t target = -1;
+  std::unordered_map<int64_t, int64_t> targets;
+  for (const auto& pair : node->source_target_pairs()) {
+    LTC_CHECK(targets.emplace(pair.first, pair.second).second)
+        << "Rank " << pair.first << " is the source of more than one pair";
+    if (pair.second == rank) {
+      LTC_CHECK_EQ(source, -1) << "Rank " << rank << " is the target of more than one pair";
+      source = pair.first;
+    }
+  }
+  if (targets.count(rank)) {
+    target = targets.at(rank);
+  }
+  if (source == rank) {
+    Var ret = BindSymbol(raf::ir::Call(Op::Get("raf.op.copy"), {x}));
+    return BindSymbol(raf::ir::Tuple(Array<Expr>({ret, token})));
+  }
+  // The sends and the receives block until matched, so a rank sends before it receives, except
+  // the lowest rank of a cycle of pairs, which starts the cycle by receiving first.
+  bool receive_first = false;
+  if (source >= 0 && target >= 0) {
+    int64_t lowest = rank;
+    int64_t peer = target;
+    while (peer != rank && targets.count(peer)) {
+      lowest = std::min(lowest, peer);
+      peer = targets.at(peer);
+    }
+    receive_first = peer == rank && lowest == rank;
+  }
+  const lazy_tensors::Shape& shape = node->operand(0).shape();
+  std::vector<int64_t> dimensions(shape.dimensions().begin(), shape.dimensions().end());
+  Expr recv_shape = MakeConstant(TupleInt(dimensions));
+  Expr recv_dtype = MakeConstant(String(DLDataType2String(ToRAFDType(shape.element_type()))));
+  auto send = [&](Expr dep) {
+    return BindSymbol(
+        raf::ir::Call(Op::Get("raf.op._send"), {x, MakeConstant(Int(target)), dep}));
+  };
+  auto recv = [&](Expr dep) {
+    return BindSymbol(raf::ir::Call(Op::Get("raf.op._recv"),
+                                    {MakeConstant(Int(source)), recv_shape, recv_dtype, dep}));
+  };
+  Var ret;
+  Var last = token;
+  if (receive_first) {
+    ret = recv(token);
+    last = send(ret);
+  } else {
+    if (target >= 0) {
+      last = send(token);
+    }
+    ret = source >= 0 ? recv(last) : BindSymbol(raf::ir::Call(Op::Get("raf.op.zeros_like"), {x}));
+    last = source >= 0 ? ret : last;
+  }
+  // The last send or receive is returned as the token, so that both stay in the graph.
+  return BindSymbol(raf::ir::Tuple(Array<Expr>({ret, last})));
+}
+
+Var RAFNodeLowering::LowerCollectivePermute(const ir::ops::CollectivePermute* node) {
+  LTC_CHECK_EQ(node->num_outputs(), 2);
+  std::vector<Var> ops;
+  for (const auto& op : node->operands()) ops.push_back(loctx()->GetOutputOp(op));
+  return BuildCollectivePermute(ops, node);
+}
+
 lazy_tensors::Shape RAFNodeLowering::Infer(const ir::Node* node) {
   const ir::OpKind& kind = node->op();
   switch (kind.op) {
@@ -1518,6 +1663,13 @@ lazy_tensors::Shape RAFNodeLowering::Infer(const ir::Node* node) {
         return InferReduceScatter(
             ir::NodeCast<ir::ops::ReduceScatter>(node, *ir::ops::ltc_reduce_scatter));
       }
+      if (kind == *ir::ops::ltc_all_to_all) {
+        return InferAllToAll(ir::NodeCast<ir::ops::AllToAll>(node, *ir::ops::ltc_all_to_all));
+      }
+      if (kind == *ir::ops::ltc_collective_permute) {
+        return InferCollectivePermute(
+            ir::NodeCast<ir::ops::CollectivePermute>(node, *ir::ops::ltc_collective_permute));
+      }
       if (kind == *ir::ops::raf_dropout_backward) {
         return InferDropoutBackward(
             ir::NodeCast<ir::ops::DropoutBackward>(node, *ir::ops::raf_dropout_backward));
@@ -1736,6 +1888,27 @@ lazy_tensors::Shape RAFNodeLowering::InferReduceScatter(const ir::ops::ReduceSca
   return ToLTCShape(body->checked_type());
 }
 
+lazy_tensors::Shape RAFNodeLowering::InferAllToAll(const ir::ops::AllToAll* node) {
+  std::vector<Var> ops;
+  for (const auto& x : node->operands()) {
+    ops.push_back(MakeVar("operand", ToRAFType(x.shape())));
+  }
+  Var out = BuildAllToAll(ops, node);
+  Expr body = InferType(ExtractBinding(out, ops));
+  return ToLTCShape(body->checked_type());
+}
+
+lazy_tensors::Shape RAFNodeLowering::InferCollectivePermute(
+    const ir::ops::CollectivePermute* node) {
+  std::vector<Var> ops;
+  for (const auto& x : node->operands()) {
+    ops.push_back(MakeVar("operand", ToRAFType(x.shape())));
+  }
+  Var out = BuildCollectivePermute(ops, node);
+  Expr body = InferType(ExtractBinding(out, ops));
+  return ToLTCShape(body->checked_type());
+}
+
 lazy_tensors::Shape RAFNodeLowering::InferMaxInDim(const ir::ops::MaxInDim* node) {
   LTC_CHECK_EQ(node->operands().size(), 1U);
   std::vector<Var> ops;
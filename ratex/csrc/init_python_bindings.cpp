@@ -9,6 +9,7 @@
 #include "lazy_tensor_core/csrc/device.h"
 #include "lazy_tensor_core/csrc/tensor_util.h"
 #include "lazy_tensors/shape.h"
+#include "lazy_tensors/computation_client/shm_collectives.h"
 #include "lazy_tensor_core/csrc/ops/device_data.h"
 #include "ratex/csrc/aten_raf_bridge.h"
 #include "ratex/csrc/ops/relay_expr.h"
@@ -58,6 +59,84 @@ std::shared_ptr<ir::Value> CreateToken(const std::string& device_str) {
   return std::make_shared<ir::Value>(std::move(ir_value));
 }
 
+// The shared memory collectives run on the host tensors in place.
+void* GetShmTensorData(const at::Tensor& tensor) {
+  LTC_CHECK(tensor.device().is_cpu() && tensor.is_contiguous())
+      << "Shared memory collectives take contiguous CPU tensors";
+  return tensor.data_ptr();
+}
+
+void InitShmCollectivesBindings(py::module m) {
+  using lazy_tensors::ShmCommunicator;
+  py::class_<ShmCommunicator, std::shared_ptr<ShmCommunicator>>(m, "ShmCommunicator")
+      .def(py::init<std::string, int64_t, int64_t, int64_t, double>(), py::arg("name"),
+           py::arg("rank"), py::arg("size"),
+           py::arg("slot_bytes") = ShmCommunicator::kDefaultSlotBytes,
+           py::arg("timeout") = 300.0, py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("rank", &ShmCommunicator::rank)
+      .def_property_readonly("size", &ShmCommunicator::size)
+      .def(
+          "all_reduce",
+          [](ShmCommunicator& comm, const at::Tensor& tensor, const std::string& reduce_type) {
+            void* data = GetShmTensorData(tensor);
+            ShmCommunicator::ReduceOp op = ShmCommunicator::ParseReduceOp(reduce_type);
+            py::gil_scoped_release release;
+            comm.AllReduce(data, tensor.numel(), TensorTypeToLtcType(tensor.scalar_type()), op);
+          })
+      .def("all_gather",
+           [](ShmCommunicator& comm, const at::Tensor& input, const at::Tensor& output) {
+             LTC_CHECK_EQ(output.numel(), input.numel() * comm.size());
+             LTC_CHECK_EQ(output.scalar_type(), input.scalar_type());
+             const void* input_data = GetShmTensorData(input);
+             void* output_data = GetShmTensorData(output);
+             py::gil_scoped_release release;
+             comm.AllGather(input_data, output_data, input.numel(),
+                            TensorTypeToLtcType(input.scalar_type()));
+           })
+      .def("reduce_scatter",
+           [](ShmCommunicator& comm, const at::Tensor& input, const at::Tensor& output,
+              const std::string& reduce_type) {
+             LTC_CHECK_EQ(input.numel(), output.numel() * comm.size());
+             LTC_CHECK_EQ(output.scalar_type(), input.scalar_type());
+             const void* input_data = GetShmTensorData(input);
+             void* output_data = GetShmTensorData(output);
+             ShmCommunicator::ReduceOp op = ShmCommunicator::ParseReduceOp(reduce_type);
+             py::gil_scoped_release release;
+             comm.ReduceScatter(input_data, output_data, output.numel(),
+                                TensorTypeToLtcType(input.scalar_type()), op);
+           })
+      .def("broadcast",
+           [](ShmCommunicator& comm, const at::Tensor& tensor, int64_t root) {
+             void* data = GetShmTensorData(tensor);
+             py::gil_scoped_release release;
+             comm.Broadcast(data, tensor.numel(), TensorTypeToLtcType(tensor.scalar_type()),
+                            root);
+           })
+      .def("all_to_all",
+           [](ShmCommunicator& comm, const at::Tensor& input, const at::Tensor& output) {
+             LTC_CHECK_EQ(output.numel(), input.numel());
+             LTC_CHECK_EQ(input.numel() % comm.size(), 0);
+             LTC_CHECK_EQ(output.scalar_type(), input.scalar_type());
+             const void* input_data = GetShmTensorData(input);
+             void* output_data = GetShmTensorData(output);
+             py::gil_scoped_release release;
+             comm.AllToAll(input_data, output_data, input.numel() / comm.size(),
+                           TensorTypeToLtcType(input.scalar_type()));
+           })
+      .def("permute",
+           [](ShmCommunicator& comm, const at::Tensor& input, const at::Tensor& output,
+              int64_t source, int64_t target) {
+             LTC_CHECK_EQ(output.numel(), input.numel());
+             LTC_CHECK_EQ(output.scalar_type(), input.scalar_type());
+             const void* input_data = GetShmTensorData(input);
+             void* output_data = GetShmTensorData(output);
+             py::gil_scoped_release release;
+             comm.Permute(input_data, output_data, input.numel(),
+                          TensorTypeToLtcType(input.scalar_type()), source, target);
+           })
+      .def("barrier", &ShmCommunicator::Barrier, py::call_guard<py::gil_scoped_release>());
+}
+
 void InitRAFModuleBindings(py::module m) {
   m.def("_raf_invoke_relay",
         [](at::Tensor func, const std::vector<at::Tensor>& tensors,
@@ -157,10 +236,29 @@ void InitRAFModuleBindings(py::module m) {
   });
 
   m.def("_set_ratex_vlog_level", [](int value) { c10::detail::setLogLevelFlag(value); });
+
+  m.def("_raf_executable_memory_info", []() -> py::list {
+    py::list infos;
+    for (const auto& kv : ratex::DeviceMemoryTracker::Get()->GetExecutables()) {
+      const raf::pass::MemoryEstimate& estimate = kv.second.estimate;
+      py::dict info;
+      info["id"] = kv.first;
+      info["device"] = kv.second.device;
+      info["peak_bytes"] = estimate.peak_bytes;
+      info["param_bytes"] = estimate.param_bytes;
+      info["constant_bytes"] = estimate.constant_bytes;
+      info["workspace_bytes"] = estimate.workspace_bytes;
+      info["memory_budget"] = kv.second.memory_budget;
+      info["recompute_ops"] = kv.second.recompute_ops;
+      infos.append(info);
+    }
+    return infos;
+  });
 }
 
 void InitRAFBindings(py::module m) {
   InitRAFModuleBindings(m);
+  InitShmCollectivesBindings(m);
 }
 
 }  // namespace
@@ -0,0 +1,288 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/pass/estimate_cost.cc
+ * \brief Estimate the FLOPs, the memory traffic and the exposed communication time of a function
+ * from the tensor shapes.
+ */
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+#include "raf/op.h"
+#include "raf/ir.h"
+#include "raf/pass.h"
+#include "raf/src/common/shape_utils.h"
+#include "raf/src/pass/common.h"
+#include "raf/src/pass/let_list.h"
+#include "ratex/csrc/pass_ext/pass.h"
+
+namespace raf {
+
+namespace pass {
+
+namespace estimate_cost {
+
+using namespace raf::ir;
+using namespace raf::op;
+
+/*! \brief The total bytes of the tensors in the given type. */
+int64_t BytesOfType(const Type& type) {
+  if (const auto* tty = type.as<TensorTypeNode>()) {
+    return common::shape_utils::BytesCompactTensor(tty);
+  }
+  int64_t nbytes = 0;
+  if (const auto* tuple_type = type.as<TupleTypeNode>()) {
+    for (const auto& field : tuple_type->fields) {
+      nbytes += BytesOfType(field);
+    }
+  }
+  return nbytes;
+}
+
+/*! \brief The number of elements of a tensor type, or the largest field of a tuple type. */
+int64_t NumElements(const Type& type) {
+  if (const auto* tty = type.as<TensorTypeNode>()) {
+    int64_t nelem = 1;
+    for (const auto& dim : tty->shape) {
+      const auto* imm = dim.as<IntImmNode>();
+      if (imm == nullptr) {
+        return 0;
+      }
+      nelem *= imm->value;
+    }
+    return nelem;
+  }
+  int64_t nelem = 0;
+  if (const auto* tuple_type = type.as<TupleTypeNode>()) {
+    for (const auto& field : tuple_type->fields) {
+      nelem = std::max(nelem, NumElements(field));
+    }
+  }
+  return nelem;
+}
+
+/*! \brief The extent of the given axis of a tensor type, or 0 if it is unknown. */
+int64_t Dim(const Type& type, int axis) {
+  const auto* tty = type.as<TensorTypeNode>();
+  if (tty == nullptr || axis >= static_cast<int>(tty->shape.size())) {
+    return 0;
+  }
+  const auto* imm = tty->shape[axis].as<IntImmNode>();
+  return imm ? imm->value : 0;
+}
+
+/*!
+ * \brief The FLOPs of an operator call. Matrix multiplications and convolutions count a
+ * multiply-add as two FLOPs, while the others are assumed to do one FLOP per element.
+ */
+int64_t EstimateFLOPs(const std::string& name, const std::vector<Type>& arg_types,
+                      const Type& out_type) {
+  int64_t out = NumElements(out_type);
+  auto arg_elems = [&](size_t i) -> int64_t {
+    return i < arg_types.size() ? NumElements(arg_types[i]) : 0;
+  };
+  if (out == 0) {
+    return 0;
+  }
+  if (name.rfind("raf.op.batch_matmul", 0) == 0) {
+    // [B, M, K] x [B, K, N] -> [B, M, N]
+    int64_t batch = Dim(out_type, 0);
+    if (batch > 0) {
+      double k2 = static_cast<double>(arg_elems(0)) * arg_elems(1) / out / batch;
+      return 2 * out * static_cast<int64_t>(std::llround(std::sqrt(k2)));
+    }
+  } else if (name.rfind("raf.op.matmul", 0) == 0 || name == "raf.op.dense") {
+    // [M, K] x [K, N] -> [M, N], regardless of the transposes.
+    double k2 = static_cast<double>(arg_elems(0)) * arg_elems(1) / out;
+    return 2 * out * static_cast<int64_t>(std::llround(std::sqrt(k2)));
+  } else if (name == "raf.op.conv2d") {
+    // Each output element reduces over in_channels / groups * kernel_h * kernel_w of w.
+    int64_t out_channels = arg_types.size() > 1 ? Dim(arg_types[1], 0) : 0;
+    if (out_channels > 0) {
+      return 2 * out * (arg_elems(1) / out_channels);
+    }
+  } else if ((name == "raf.op.conv2d_dx" || name == "raf.op.conv2d_dw") && arg_types.size() > 2) {
+    // conv2d_dx(w, y, dy, ...) and conv2d_dw(x, y, dy, ...) cost the same as the forward.
+    const Type& w_type = name == "raf.op.conv2d_dx" ? arg_types[0] : out_type;
+    int64_t out_channels = Dim(w_type, 0);
+    if (out_channels > 0) {
+      return 2 * arg_elems(2) * (NumElements(w_type) / out_channels);
+    }
+  }
+  int64_t nelem = out;
+  for (size_t i = 0; i < arg_types.size(); ++i) {
+    nelem = std::max(nelem, arg_elems(i));
+  }
+  return nelem;
+}
+
+int64_t EstimateFLOPs(const std::string& name, const CallNode* call) {
+  std::vector<Type> arg_types;
+  for (const auto& arg : call->args) {
+    arg_types.push_back(arg->checked_type());
+  }
+  return EstimateFLOPs(name, arg_types, call->checked_type());
+}
+
+/*!
+ * \brief Whether the call only manages the memory or the streams of the VM, e.g. alloc_tensor,
+ * free or wait_event, which the timeline ignores.
+ */
+bool IsBookkeeping(const CallNode* call) {
+  static const std::unordered_set<std::string> stream_ops = {
+      "raf.op.set_stream", "raf.op.add_event", "raf.op.wait_event", "raf.op.stream_barrier"};
+  const auto* op = call->op.as<OpNode>();
+  if (op == nullptr || op->name == "raf.op.vm.invoke_op") {
+    return false;
+  }
+  return op->name.rfind("raf.op.vm.", 0) == 0 || stream_ops.count(op->name);
+}
+
+/*! \brief The fields of a tuple, either given inline or bound to a var, or the expr itself. */
+Array<Expr> Fields(const Expr& expr, const std::unordered_map<const VarNode*, Expr>& bound) {
+  Expr value = expr;
+  if (const auto* var = expr.as<VarNode>()) {
+    auto it = bound.find(var);
+    if (it != bound.end()) {
+      value = it->second;
+    }
+  }
+  if (const auto* tuple = value.as<TupleNode>()) {
+    return tuple->fields;
+  }
+  return {expr};
+}
+
+CostEstimate EstimateCost(const Function& func) {
+  CostEstimate estimate;
+  std::unique_ptr<ExplicitLetList> ell = ExplicitLetList::make(func->body);
+  for (const auto& expr : ell->exprs) {
+    const auto* call = expr.as<CallNode>();
+    if (call == nullptr) {
+      continue;
+    }
+    std::string name = "closure";
+    if (const auto* op = call->op.as<OpNode>()) {
+      name = op->name;
+    } else if (const auto* gvar = call->op.as<GlobalVarNode>()) {
+      name = gvar->name_hint;
+    }
+    estimate.op_counts[name]++;
+    estimate.flops += EstimateFLOPs(name, call);
+    estimate.bytes_moved += BytesOfType(call->checked_type());
+    for (const auto& arg : call->args) {
+      estimate.bytes_moved += BytesOfType(arg->checked_type());
+    }
+  }
+  return estimate;
+}
+
+OverlapEstimate EstimateOverlap(const Function& func, const OverlapCostModel& model) {
+  static const Op& invoke_op = Op::Get("raf.op.vm.invoke_op");
+  OverlapEstimate estimate;
+  // The time each var is ready at, and the times each stream is free at.
+  std::unordered_map<const VarNode*, double> ready;
+  double compute_clock = 0, comm_clock = 0;
+  // The index of the last computation each var depends on, and of the last computation issued.
+  std::unordered_map<const VarNode*, int64_t> producer;
+  int64_t last_compute = -1;
+  std::unordered_map<const VarNode*, Expr> bound;
+  std::unique_ptr<ExplicitLetList> ell = ExplicitLetList::make(func->body);
+  for (size_t i = 0; i < ell->vars.size(); ++i) {
+    const Var& var = ell->vars[i];
+    const Expr& expr = ell->exprs[i];
+    bound[var.get()] = expr;
+    double inputs_ready = 0;
+    int64_t inputs_producer = -1;
+    for (const auto& free_var : FreeVars(expr)) {
+      auto it = ready.find(free_var.get());
+      if (it != ready.end()) {
+        inputs_ready = std::max(inputs_ready, it->second);
+        inputs_producer = std::max(inputs_producer, producer[free_var.get()]);
+      }
+    }
+    const auto* call = expr.as<CallNode>();
+    if (call == nullptr || IsBookkeeping(call)) {
+      // Tuples, projections and the memory management of the VM only refer to their operands.
+      ready[var.get()] = inputs_ready;
+      producer[var.get()] = inputs_producer;
+      continue;
+    }
+    // A lowered call invoke_op(op, inputs, outputs) writes its outputs to the given buffers.
+    Expr op = call->op;
+    std::vector<Type> arg_types;
+    Type out_type = call->checked_type();
+    std::vector<const VarNode*> written = {var.get()};
+    if (op.same_as(invoke_op)) {
+      op = call->args[0];
+      for (const auto& arg : Fields(call->args[1], bound)) {
+        arg_types.push_back(arg->checked_type());
+      }
+      Array<Expr> outputs = Fields(call->args[2], bound);
+      out_type = outputs.size() == 1 ? outputs[0]->checked_type() : call->args[2]->checked_type();
+      for (const auto& output : outputs) {
+        if (const auto* output_var = output.as<VarNode>()) {
+          written.push_back(output_var);
+        }
+      }
+    } else {
+      for (const auto& arg : call->args) {
+        arg_types.push_back(arg->checked_type());
+      }
+    }
+    int64_t nbytes = BytesOfType(out_type);
+    int64_t in_bytes = 0;
+    for (const auto& arg_type : arg_types) {
+      in_bytes += BytesOfType(arg_type);
+    }
+    if (IsCollective(expr)) {
+      int64_t comm_bytes = std::max(in_bytes, nbytes);
+      double cost = comm_bytes / model.comm_bytes_per_us;
+      comm_clock = std::max({comm_clock, compute_clock, inputs_ready}) + cost;
+      for (const auto* written_var : written) {
+        ready[written_var] = comm_clock;
+        producer[written_var] = inputs_producer;
+      }
+      estimate.num_collectives++;
+      estimate.num_delayed_collectives += last_compute > inputs_producer;
+      estimate.comm_bytes += comm_bytes;
+      estimate.comm_us += cost;
+      continue;
+    }
+    std::string name = "closure";
+    if (const auto* op_node = op.as<OpNode>()) {
+      name = op_node->name;
+    }
+    double cost = std::max(EstimateFLOPs(name, arg_types, out_type) / model.flops_per_us,
+                           (in_bytes + nbytes) / model.bytes_per_us);
+    compute_clock = std::max(compute_clock, inputs_ready) + cost;
+    last_compute = i;
+    for (const auto* written_var : written) {
+      ready[written_var] = compute_clock;
+      producer[written_var] = last_compute;
+    }
+    estimate.compute_us += cost;
+  }
+  estimate.total_us = std::max(compute_clock, comm_clock);
+  estimate.exposed_comm_us = estimate.total_us - estimate.compute_us;
+  return estimate;
+}
+
+}  // namespace estimate_cost
+
+CostEstimate EstimateCost(const IRModule& mod) {
+  auto func = Downcast<Function>(mod->Lookup("main"));
+  return estimate_cost::EstimateCost(func);
+}
+
+OverlapEstimate EstimateOverlap(const IRModule& mod, const OverlapCostModel& model) {
+  auto func = Downcast<Function>(mod->Lookup("main"));
+  return estimate_cost::EstimateOverlap(func, model);
+}
+
+}  // namespace pass
+}  // namespace raf
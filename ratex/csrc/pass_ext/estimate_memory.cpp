@@ -0,0 +1,162 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/pass/estimate_memory.cc
+ * \brief Estimate the peak memory footprint of a function with a liveness analysis.
+ */
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include "raf/op.h"
+#include "raf/ir.h"
+#include "raf/pass.h"
+#include "raf/binding.h"
+#include "raf/src/common/shape_utils.h"
+#include "raf/src/pass/common.h"
+#include "raf/src/pass/let_list.h"
+#include "ratex/csrc/pass_ext/pass.h"
+
+namespace raf {
+
+namespace pass {
+
+namespace estimate_memory {
+
+using namespace raf::ir;
+using namespace raf::op;
+
+/*! \brief The total bytes of the tensors in the given type. Closures are not counted. */
+int64_t BytesOfType(const Type& type) {
+  if (!type.defined()) {
+    return 0;
+  }
+  if (const auto* tty = type.as<TensorTypeNode>()) {
+    return common::shape_utils::BytesCompactTensor(tty);
+  }
+  int64_t nbytes = 0;
+  if (const auto* tuple_type = type.as<TupleTypeNode>()) {
+    for (const auto& field : tuple_type->fields) {
+      nbytes += BytesOfType(field);
+    }
+  }
+  return nbytes;
+}
+
+/*!
+ * \brief Walk the A-normal form of a function in execution order. A binding allocates a new
+ * buffer unless it is a tuple, a tuple projection, a var or an in-place update (marked by
+ * may_share, or an add or subtract with an "out" argument as InplaceUpdateByAlias emits), in
+ * which case it refers to the buffers of its operands. A buffer is released right after its last reference.
+ */
+class MemoryEstimator {
+ public:
+  MemoryEstimate operator()(const Function& func) {
+    MemoryEstimate estimate;
+    for (const auto& param : func->params) {
+      estimate.param_bytes += BytesOfType(param->checked_type_);
+    }
+    std::unordered_set<const Object*> visited_constants;
+    PostOrderVisit(func->body, [&](const Expr& expr) {
+      if (expr->IsInstance<ConstantNode>() && visited_constants.insert(expr.get()).second) {
+        estimate.constant_bytes += BytesOfType(expr->checked_type_);
+      }
+    });
+
+    std::unique_ptr<ExplicitLetList> ell = ExplicitLetList::make(func->body);
+    const std::vector<Var>& vars = ell->vars;
+    const std::vector<Expr>& exprs = ell->exprs;
+    size_t n = vars.size();
+    CHECK_EQ(vars.size(), exprs.size());
+
+    for (size_t i = 0; i < n; ++i) {
+      const Var& var = vars[i];
+      const Expr& expr = exprs[i];
+      std::vector<const VarNode*> operand_buffers;
+      for (const auto& free_var : FreeVars(expr)) {
+        for (const VarNode* buffer : GetBuffers(free_var)) {
+          last_use_[buffer] = i;
+          operand_buffers.push_back(buffer);
+        }
+      }
+      const auto* extended_var = static_cast<const ExtendedVarNode*>(var.operator->());
+      if (expr->IsInstance<CallNode>()) {
+        estimate.num_calls++;
+      }
+      if (expr->IsInstance<TupleNode>() || expr->IsInstance<TupleGetItemNode>() ||
+          expr->IsInstance<VarNode>()) {
+        buffers_[var.get()] = std::move(operand_buffers);
+      } else if (extended_var && extended_var->may_share.defined()) {
+        buffers_[var.get()] = GetBuffers(extended_var->may_share);
+      } else if (const VarNode* out = InplaceOutput(expr)) {
+        // Written to the buffer of its "out" argument, e.g. a parameter aliased with an output.
+        buffers_[var.get()] = GetBuffers(GetRef<Var>(out));
+      } else {
+        nbytes_[var.get()] = BytesOfType(var->checked_type_);
+        last_use_[var.get()] = i;
+        buffers_[var.get()] = {var.get()};
+      }
+    }
+    // The returned buffers are alive until the function exits.
+    if (const auto* ret_var = ell->ret.as<VarNode>()) {
+      for (const VarNode* buffer : GetBuffers(GetRef<Var>(ret_var))) {
+        last_use_[buffer] = n;
+      }
+    }
+
+    std::vector<std::vector<const VarNode*>> releases(n + 1);
+    for (const auto& kv : last_use_) {
+      releases[kv.second].push_back(kv.first);
+    }
+    int64_t live_bytes = 0;
+    for (size_t i = 0; i < n; ++i) {
+      auto it = nbytes_.find(vars[i].get());
+      if (it != nbytes_.end()) {
+        live_bytes += it->second;
+        estimate.workspace_bytes = std::max(estimate.workspace_bytes, live_bytes);
+      }
+      for (const VarNode* buffer : releases[i]) {
+        live_bytes -= nbytes_.at(buffer);
+      }
+    }
+    estimate.peak_bytes = estimate.param_bytes + estimate.constant_bytes + estimate.workspace_bytes;
+    return estimate;
+  }
+
+ private:
+  /*! \brief The var passed as the "out" argument of an in-place add or subtract, if any. */
+  static const VarNode* InplaceOutput(const Expr& expr) {
+    static auto add_op = Op::Get("raf.op.add");
+    static auto subtract_op = Op::Get("raf.op.subtract");
+    const auto* call = expr.as<CallNode>();
+    if (call == nullptr || (call->op != add_op && call->op != subtract_op) ||
+        call->args.size() < 3) {
+      return nullptr;
+    }
+    return call->args[2].as<VarNode>();
+  }
+
+  std::vector<const VarNode*> GetBuffers(const Var& var) const {
+    auto it = buffers_.find(var.get());
+    return it != buffers_.end() ? it->second : std::vector<const VarNode*>();
+  }
+
+  /*! \brief Mapping from a let-binding var to the allocating vars whose buffers it refers to. */
+  std::unordered_map<const VarNode*, std::vector<const VarNode*>> buffers_;
+  /*! \brief The bytes allocated by each allocating var. */
+  std::unordered_map<const VarNode*, int64_t> nbytes_;
+  /*! \brief The index of the last binding referring to each allocating var. */
+  std::unordered_map<const VarNode*, size_t> last_use_;
+};
+
+}  // namespace estimate_memory
+
+MemoryEstimate EstimateMemory(const IRModule& mod) {
+  auto func = Downcast<Function>(mod->Lookup("main"));
+  return estimate_memory::MemoryEstimator()(func);
+}
+
+}  // namespace pass
+}  // namespace raf
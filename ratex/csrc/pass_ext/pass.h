@@ -9,6 +9,9 @@
  */
 #pragma once
 
+#include <map>
+#include <string>
+
 #include "raf/pass.h"
 
 namespace raf {
@@ -54,5 +57,100 @@ Pass InplaceUpdateByAlias(ir::Map<tvm::Integer, tvm::Integer> alias_map);
  */
 Pass ConvertBfFp16Constant(tvm::String bf_fp_16_dtype);
 
+/*! \brief The estimated memory footprint of a function, in bytes. */
+struct MemoryEstimate {
+  /*! \brief The total size of the function parameters. */
+  int64_t param_bytes = 0;
+  /*! \brief The total size of the constants embedded in the function. */
+  int64_t constant_bytes = 0;
+  /*! \brief The peak size of the intermediate and output tensors alive at the same time. */
+  int64_t workspace_bytes = 0;
+  /*! \brief The sum of the above, i.e. the peak working set of one execution. */
+  int64_t peak_bytes = 0;
+  /*! \brief The number of operator calls, which grows with the recomputation. */
+  int64_t num_calls = 0;
+};
+
+/*!
+ * \brief Estimate the peak memory of the main function with a liveness analysis over its
+ * A-normal form. The module has to be type inferred.
+ * \param mod The module to be analyzed.
+ * \return The memory estimate.
+ */
+MemoryEstimate EstimateMemory(const ir::IRModule& mod);
+
+/*! \brief The estimated compute cost of a function. */
+struct CostEstimate {
+  /*! \brief The floating point operations. */
+  int64_t flops = 0;
+  /*! \brief The bytes read and written by the operator calls. */
+  int64_t bytes_moved = 0;
+  /*! \brief The number of calls of each operator. */
+  std::map<std::string, int64_t> op_counts;
+};
+
+/*!
+ * \brief Estimate the compute cost of the main function analytically from the tensor shapes,
+ * without compiling or running any kernel. The module has to be type inferred.
+ * \param mod The module to be analyzed.
+ * \return The cost estimate.
+ */
+CostEstimate EstimateCost(const ir::IRModule& mod);
+
+/*!
+ * \brief Whether the expression is a call to a collective communication operator, including the
+ * dialect ops and the collectives lowered to raf.op.vm.invoke_op.
+ */
+bool IsCollective(const ir::Expr& expr);
+
+/*!
+ * \brief Reorder the bindings of the main function to overlap the collectives with the
+ * computation. Each collective is issued as soon as its inputs are computed, and its consumers
+ * are deferred until no independent computation is left.
+ * \return The pass.
+ */
+Pass ScheduleCollectives();
+
+/*! \brief The device throughputs of the overlap cost model. */
+struct OverlapCostModel {
+  /*! \brief The floating point operations per microsecond. */
+  double flops_per_us = 15e6;
+  /*! \brief The bytes of device memory read or written per microsecond. */
+  double bytes_per_us = 9e5;
+  /*! \brief The bytes of the input of a collective communicated per microsecond. */
+  double comm_bytes_per_us = 1e4;
+};
+
+/*! \brief The estimated timeline of a function, in microseconds. */
+struct OverlapEstimate {
+  /*! \brief The number of collectives. */
+  int64_t num_collectives = 0;
+  /*! \brief The collectives issued after a computation their inputs do not depend on. */
+  int64_t num_delayed_collectives = 0;
+  /*! \brief The bytes communicated by the collectives. */
+  int64_t comm_bytes = 0;
+  /*! \brief The time spent computing, excluding the waits for the collectives. */
+  double compute_us = 0;
+  /*! \brief The time spent communicating. */
+  double comm_us = 0;
+  /*! \brief The time of one execution. */
+  double total_us = 0;
+  /*! \brief The communication time not hidden behind the computation, i.e. total - compute. */
+  double exposed_comm_us = 0;
+};
+
+/*!
+ * \brief Estimate the exposed communication time of the main function by simulating one stream
+ * of computation and one of communication. The bindings are issued in order, a collective starts
+ * once issued, its inputs are ready and the previous collective is done, and the computation
+ * waits only for the collectives it consumes. The module has to be type inferred, and may be
+ * lowered by the VM compiler, in which case the calls are read from raf.op.vm.invoke_op and the
+ * memory and stream management is ignored.
+ * \param mod The module to be analyzed.
+ * \param model The throughputs of the device.
+ * \return The overlap estimate.
+ */
+OverlapEstimate EstimateOverlap(const ir::IRModule& mod, const OverlapCostModel& model = {});
+
 }  // namespace pass
 }  // namespace raf
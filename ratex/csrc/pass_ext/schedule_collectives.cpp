@@ -0,0 +1,229 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*!
+ * \file src/pass/schedule_collectives.cc
+ * \brief Reorder the bindings of a function to overlap the collectives with the computation.
+ */
+#include <algorithm>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include "raf/op.h"
+#include "raf/ir.h"
+#include "raf/pass.h"
+#include "raf/src/pass/common.h"
+#include "raf/src/pass/let_list.h"
+#include "ratex/csrc/pass_ext/pass.h"
+
+namespace raf {
+
+namespace pass {
+
+namespace schedule_collectives {
+
+using namespace raf::ir;
+using namespace raf::op;
+
+/*! \brief The scheduling classes of the bindings, in the order they are picked when ready. */
+enum Priority {
+  /*! \brief The collectives, issued as soon as their inputs are ready. */
+  kCollective = 0,
+  /*! \brief The computation producing the inputs of a collective. */
+  kFeedsCollective = 1,
+  /*! \brief The computation independent of the collectives. */
+  kIndependent = 2,
+  /*! \brief The consumers of the collectives, sunk as late as possible. */
+  kConsumesCollective = 3,
+};
+
+/*! \brief The parameter updated in-place by a call, i.e. passed as its "out" argument. */
+const VarNode* InplaceTarget(const Expr& expr, const std::unordered_set<const VarNode*>& params) {
+  static auto add_op = Op::Get("raf.op.add");
+  static auto subtract_op = Op::Get("raf.op.subtract");
+  const auto* call = expr.as<CallNode>();
+  if (call == nullptr || (call->op != add_op && call->op != subtract_op) ||
+      call->args.size() < 3) {
+    return nullptr;
+  }
+  const auto* out = call->args[2].as<VarNode>();
+  return out != nullptr && params.count(out) ? out : nullptr;
+}
+
+/*!
+ * \brief List schedule the A-normal form of a function. A binding is ready once the bindings of
+ * its free vars are scheduled, and the ready binding of the lowest priority class is scheduled
+ * next. Thus a collective is issued right after its inputs are computed, the inputs of the
+ * earliest collective are computed first, and the computation depending on the output of a
+ * collective is deferred until no independent computation is left to overlap with it. The
+ * collectives keep their relative order so that all the ranks issue them in the same order, the
+ * output binding stays last, and the accesses to a parameter updated in-place keep their order
+ * relative to the update.
+ */
+class CollectiveScheduler {
+ public:
+  Function operator()(const Function& func) {
+    std::unique_ptr<ExplicitLetList> ell = ExplicitLetList::make(func->body);
+    const std::vector<Var>& vars = ell->vars;
+    const std::vector<Expr>& exprs = ell->exprs;
+    int n = vars.size();
+    CHECK_EQ(vars.size(), exprs.size());
+    // The output binding is pinned at the end.
+    int m = n > 0 && vars[n - 1].same_as(ell->ret) ? n - 1 : n;
+
+    std::unordered_map<const VarNode*, int> index;
+    for (int i = 0; i < n; ++i) {
+      index[vars[i].get()] = i;
+    }
+    std::unordered_set<const VarNode*> params;
+    for (const auto& param : func->params) {
+      params.insert(param.get());
+    }
+
+    std::vector<std::vector<int>> users(m);
+    std::vector<int> num_deps(m, 0);
+    auto add_edge = [&](int from, int to) {
+      users[from].push_back(to);
+      ++num_deps[to];
+    };
+    std::vector<bool> is_collective(m, false);
+    std::unordered_map<const VarNode*, std::vector<int>> param_readers;
+    std::unordered_map<const VarNode*, int> param_writer;
+    int last_collective = -1;
+    for (int i = 0; i < m; ++i) {
+      is_collective[i] = IsCollective(exprs[i]);
+      if (is_collective[i]) {
+        if (last_collective >= 0) {
+          add_edge(last_collective, i);
+        }
+        last_collective = i;
+      }
+      std::unordered_set<int> deps;
+      for (const auto& free_var : FreeVars(exprs[i])) {
+        auto it = index.find(free_var.get());
+        if (it != index.end() && it->second < i) {
+          deps.insert(it->second);
+        } else if (params.count(free_var.get())) {
+          param_readers[free_var.get()].push_back(i);
+          auto writer = param_writer.find(free_var.get());
+          if (writer != param_writer.end()) {
+            deps.insert(writer->second);
+          }
+        }
+      }
+      if (const VarNode* target = InplaceTarget(exprs[i], params)) {
+        for (int reader : param_readers[target]) {
+          if (reader != i) {
+            deps.insert(reader);
+          }
+        }
+        param_writer[target] = i;
+      }
+      for (int dep : deps) {
+        add_edge(dep, i);
+      }
+    }
+
+    // The feeders of the collectives are ranked by the first collective they feed, the others
+    // by their original index.
+    std::vector<int> priority(m, kIndependent);
+    std::vector<int> next_collective(m, m);
+    for (int i = m - 1; i >= 0; --i) {
+      for (int user : users[i]) {
+        next_collective[i] =
+            std::min(next_collective[i], is_collective[user] ? user : next_collective[user]);
+      }
+    }
+    std::vector<bool> consumes_collective(m, false);
+    for (int i = 0; i < m; ++i) {
+      for (int user : users[i]) {
+        consumes_collective[user] =
+            consumes_collective[user] || is_collective[i] || consumes_collective[i];
+      }
+      if (is_collective[i]) {
+        priority[i] = kCollective;
+      } else if (next_collective[i] < m) {
+        priority[i] = kFeedsCollective;
+      } else if (consumes_collective[i]) {
+        priority[i] = kConsumesCollective;
+      }
+    }
+    auto key = [&](int i) {
+      return std::make_tuple(priority[i], priority[i] == kFeedsCollective ? next_collective[i] : 0,
+                             i);
+    };
+
+    std::set<std::tuple<int, int, int>> ready;
+    for (int i = 0; i < m; ++i) {
+      if (num_deps[i] == 0) {
+        ready.insert(key(i));
+      }
+    }
+    std::vector<int> order;
+    while (!ready.empty()) {
+      int i = std::get<2>(*ready.begin());
+      ready.erase(ready.begin());
+      order.push_back(i);
+      for (int user : users[i]) {
+        if (--num_deps[user] == 0) {
+          ready.insert(key(user));
+        }
+      }
+    }
+    CHECK_EQ(order.size(), static_cast<size_t>(m)) << "The bindings have a cyclic dependency";
+    for (int i = m; i < n; ++i) {
+      order.push_back(i);
+    }
+
+    Expr body = LetList::With([&](LetList* ll) {
+      for (int i : order) {
+        ll->Push(vars[i], exprs[i]);
+      }
+      return ell->ret;
+    });
+    return Function(func->params, body, func->ret_type, func->type_params);
+  }
+};
+
+}  // namespace schedule_collectives
+
+bool IsCollective(const Expr& expr) {
+  // Match the base names, so that the dialect ops (e.g., raf.op.nccl._allreduce) are included.
+  static const std::unordered_set<std::string> collectives = {
+      "_allreduce", "_allgather", "_reduce_scatter", "_all_to_all",
+      "_broadcast", "_reduce",    "_send",           "_recv",
+  };
+  static const Op& invoke_op = Op::Get("raf.op.vm.invoke_op");
+  const auto* call = expr.as<CallNode>();
+  if (call == nullptr) {
+    return false;
+  }
+  // The VM compiler lowers every call to invoke_op(op, inputs, outputs).
+  Expr callee = call->op.same_as(invoke_op) ? call->args[0] : call->op;
+  const auto* op = callee.as<OpNode>();
+  if (op == nullptr || op->name.rfind("raf.op.", 0) != 0) {
+    return false;
+  }
+  return collectives.count(op->name.substr(op->name.rfind('.') + 1));
+}
+
+Pass ScheduleCollectives() {
+  return CreateModulePass(
+      [=](IRModule mod, const PassContext& pass_ctx) {
+        auto entry = ir::Downcast<ir::Function>(mod->Lookup("main"));
+        ir::BaseFunc updated_entry = schedule_collectives::CollectiveScheduler()(entry);
+        ir::IRModule updated_mod = ir::IRModule(mod->functions);
+        updated_mod->Add(updated_mod->GetGlobalVar("main"), updated_entry, true);
+        return updated_mod;
+      },
+      1, "ScheduleCollectives", {});
+}
+
+RAF_REGISTER_GLOBAL("raf.pass_.ScheduleCollectives").set_body_typed(ScheduleCollectives);
+
+}  // namespace pass
+}  // namespace raf
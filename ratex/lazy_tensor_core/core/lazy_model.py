@@ -6,6 +6,7 @@
 from __future__ import print_function
 
 import collections
+import contextlib
 import io
 import sys
 import os
@@ -666,7 +667,7 @@ def collective_permute(value, pairs):
       The result `torch.Tensor` of the `collective_permute()` operation.
     """
     token, devctx = _get_all_reduce_token()
-    result = _RATEXC._ltc_collective_permute(value, token, pairs)
+    result = _RATEXC._ltc_collective_permute(value, token, pairs, get_ordinal())
     devctx.all_reduce_token = result[1]
     return result[0]
 
@@ -833,6 +834,64 @@ def _maybe_convert_to_cpu(data, convert=True):
     return ToLazyTensorArena(convert_fn, select_fn).transform(data)
 
 
+class HostFuture(object):
+    """The CPU values of lazy tensors being fetched by `prefetch_to_host()`."""
+
+    def __init__(self, future, is_tensor):
+        self._future = future
+        self._is_tensor = is_tensor
+
+    def done(self):
+        """Returns whether the values are on the host."""
+        return self._future.done()
+
+    def result(self):
+        """Waits for the values and returns the CPU tensor(s)."""
+        tensors = self._future.result()
+        return tensors[0] if self._is_tensor else tensors
+
+
+def prefetch_to_host(tensors):
+    """Starts fetching the values of lazy tensors to the host without blocking.
+
+    The pending operations of the tensors are executed as by `tensor.cpu()`,
+    but the values are copied to the host in background right after the
+    execution, so that reading e.g. the loss of every step does not make the
+    host wait for the device.
+
+    Args:
+      tensors (torch.Tensor or list of torch.Tensor): The lazy tensors to fetch.
+
+    Returns:
+      A `HostFuture` whose `result()` is the CPU tensor, or the list of CPU
+      tensors, of the given lazy tensors.
+    """
+    is_tensor = isinstance(tensors, torch.Tensor)
+    if is_tensor:
+        tensors = [tensors]
+    return HostFuture(_RATEXC._ltc_prefetch_to_host(list(tensors)), is_tensor)
+
+
+@contextlib.contextmanager
+def closure_priority(priority):
+    """Sets the priority class of the runtime work started by the current thread.
+
+    The transfers and copies started by the current thread within the context run on the
+    runtime thread pools with the given priority. The queued work of the "execution",
+    "transfer", "default" and "background" classes runs in this order, and the background class
+    is limited to half of each pool by default (see `LTC_THREAD_POOL_LIMITS`), so that uploads
+    nobody waits for yet do not delay the graph executions.
+
+    Args:
+      priority (string): The name of the priority class.
+    """
+    previous = _RATEXC._ltc_set_closure_priority(priority)
+    try:
+        yield
+    finally:
+        _RATEXC._ltc_set_closure_priority(previous)
+
+
 def send_cpu_data_to_device(data, device):
     def convert_fn(tensors):
         devices = [str(device)] * len(tensors)
@@ -949,7 +1008,7 @@ def get_memory_info(device):
       device (string): The device whose memory information are requested.
 
     Returns:
-      A dictionary with `kb_free` (free memory in KB) and `kb_total` (total
-      memory in KB) keys.
+      A dictionary with `kb_free` (free memory in KB), `kb_total` (total
+      memory in KB) and `kb_peak` (peak memory in use in KB) keys.
     """
     return _RATEXC._ltc_memory_info(str(device))
@@ -232,11 +232,11 @@ std::pair<at::Tensor, std::shared_ptr<ir::Value>> ReduceScatter(
 
 std::pair<at::Tensor, std::shared_ptr<ir::Value>> CollectivePermute(
     const at::Tensor& input, const std::shared_ptr<ir::Value>& token,
-    const std::vector<std::pair<int64_t, int64_t>>& source_target_pairs) {
+    const std::vector<std::pair<int64_t, int64_t>>& source_target_pairs, int64_t rank) {
   LazyTensor result;
   ir::Value new_token;
-  std::tie(result, new_token) =
-      LazyTensor::collective_permute(bridge::GetLtcTensor(input), *token, source_target_pairs);
+  std::tie(result, new_token) = LazyTensor::collective_permute(bridge::GetLtcTensor(input),
+                                                               *token, source_target_pairs, rank);
   return std::pair<at::Tensor, std::shared_ptr<ir::Value>>(
       bridge::AtenFromLtcTensor(std::move(result)), std::make_shared<ir::Value>(new_token));
 }
@@ -407,6 +407,7 @@ py::dict GetMemoryInfo(const std::string& device_str) {
   auto py_dict = py::dict();
   py_dict["kb_free"] = mem_info.kb_free;
   py_dict["kb_total"] = mem_info.kb_total;
+  py_dict["kb_peak"] = mem_info.kb_peak;
   return py_dict;
 }
 
@@ -462,6 +463,46 @@ void InitLtcModuleBindings(py::module m) {
     }
     return result;
   });
+  using TensorsFuture = lazy_tensors::util::Future<std::vector<at::Tensor>>;
+  py::class_<TensorsFuture>(m, "TensorsFuture")
+      .def("done", [](const TensorsFuture& future) { return future.IsReady(); })
+      .def("result", [](const TensorsFuture& future) {
+        std::vector<at::Tensor> result;
+        {
+          NoGilSection nogil;
+          for (const auto& tensor : future.Get()) {
+            result.push_back(torch::autograd::make_variable(tensor, /*requires_grad=*/false));
+          }
+        }
+        return result;
+      });
+  m.def("_ltc_prefetch_to_host", [](const std::vector<at::Tensor>& tensors) {
+    NoGilSection nogil;
+    std::vector<LazyTensor> xtensors = GetLtcTensors(tensors, /*want_all=*/true);
+    return LazyTensor::PrefetchTensors(&xtensors);
+  });
+  m.def("_ltc_set_closure_priority", [](const std::string& priority) {
+    return std::string(lazy_tensors::env::PriorityName(
+        lazy_tensors::env::SetThreadPriority(lazy_tensors::env::ParsePriority(priority))));
+  });
+  m.def("_ltc_schedule_io_closure", [](py::function closure) {
+    // The closure is released under the GIL, once it ran.
+    auto holder = std::make_shared<py::function>(std::move(closure));
+    lazy_tensors::env::ScheduleIoClosure([holder]() {
+      py::gil_scoped_acquire gil;
+      try {
+        (*holder)();
+      } catch (const std::exception& ex) {
+        LTC_LOG(ERROR) << "Exception from running IO closure: " << ex.what();
+      }
+      *holder = py::function();
+    });
+  });
+  m.def("_ltc_run_blocking", [](py::function fn) {
+    // Lets the thread pool run the queued closures while fn blocks on one.
+    lazy_tensors::env::BlockingRegion region;
+    return fn();
+  });
   m.def("_ltc_get_tensor_view_alias_id",
         [](const at::Tensor& tensor) { return GetTensorViewAliasId(tensor); });
   m.def("_ltc_get_tensor_id", [](const at::Tensor& tensor) { return GetTensorId(tensor); });
@@ -580,13 +621,13 @@ void InitLtcModuleBindings(py::module m) {
   });
   m.def("_ltc_collective_permute", [](const at::Tensor& input,
                                       const std::shared_ptr<ir::Value>& token,
-                                      const py::list& pairs) {
+                                      const py::list& pairs, int64_t rank) {
     std::vector<std::pair<int64_t, int64_t>> source_target_pairs = CreateSourceTargetPairs(pairs);
     at::Tensor result;
     std::shared_ptr<ir::Value> new_token;
     {
       NoGilSection nogil;
-      std::tie(result, new_token) = CollectivePermute(input, token, source_target_pairs);
+      std::tie(result, new_token) = CollectivePermute(input, token, source_target_pairs, rank);
     }
     auto result_tuple = py::tuple(2);
     result_tuple[0] =
@@ -18,15 +18,18 @@ namespace ir {
 namespace ops {
 
 CollectivePermute::CollectivePermute(const Value& input, const Value& token,
-                                     std::vector<std::pair<int64_t, int64_t>> source_target_pairs)
+                                     std::vector<std::pair<int64_t, int64_t>> source_target_pairs,
+                                     int64_t rank)
     : Node(ltc_collective_permute, {input, token},
-           /*num_outputs=*/2, lazy_tensors::util::MHash(source_target_pairs)),
-      source_target_pairs_(std::move(source_target_pairs)) {
+           /*num_outputs=*/2, lazy_tensors::util::MHash(source_target_pairs, rank)),
+      source_target_pairs_(std::move(source_target_pairs)),
+      rank_(rank) {
   SetShapeDeferred([&]() { return compiler::NodeLowering::Get()->Infer(this); });
 }
 
 NodePtr CollectivePermute::Clone(OpList operands) const {
-  return MakeNode<CollectivePermute>(operands.at(0), operands.at(1), source_target_pairs_);
+  return MakeNode<CollectivePermute>(operands.at(0), operands.at(1), source_target_pairs_,
+                                   rank_);
 }
 
 std::string CollectivePermute::ToString() const {
@@ -36,7 +39,7 @@ std::string CollectivePermute::ToString() const {
     ss << (i == 0 ? "(" : ", (");
     ss << source_target_pairs_[i].first << ", " << source_target_pairs_[i].second << ")";
   }
-  ss << ")";
+  ss << "), rank=" << rank_;
   return ss.str();
 }
 
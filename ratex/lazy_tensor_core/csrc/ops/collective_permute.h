@@ -17,7 +17,7 @@ namespace ops {
 class CollectivePermute : public Node {
  public:
   CollectivePermute(const Value& input, const Value& token,
-                    std::vector<std::pair<int64_t, int64_t>> source_target_pairs);
+                    std::vector<std::pair<int64_t, int64_t>> source_target_pairs, int64_t rank);
 
   std::string ToString() const override;
 
@@ -27,8 +27,12 @@ class CollectivePermute : public Node {
     return source_target_pairs_;
   }
 
+  int64_t rank() const { return rank_; }
+
  private:
   std::vector<std::pair<int64_t, int64_t>> source_target_pairs_;
+  // The pairs are lowered to the peers of this rank, so the rank is a part of the node hash.
+  int64_t rank_;
 };
 
 }  // namespace ops
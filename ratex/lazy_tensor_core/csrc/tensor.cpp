@@ -11,8 +11,10 @@
 #include <atomic>
 #include <cmath>
 #include <condition_variable>
+#include <deque>
 #include <exception>
 #include <functional>
+#include <map>
 #include <mutex>
 #include <set>
 #include <stdexcept>
@@ -63,7 +65,7 @@ thread_local TlsData g_tls_data;
 // We perform two kinds of operations of tensors, synchronous and asynchronous.
 // The ApplyPendingGraph() are synchronous, as we need the device data result
 // immediately. Before the synchronous operations can start, they need to wait
-// that the pending asynchronous operations have completed.
+// that the asynchronous operations producing their data have completed.
 // Synchronous operations do not hold device locks, since they are strictly
 // sequential, dictated by the PyTorch execution order.
 // The SyncTensorsGraph() is asynchronous, and returns immediately after having
@@ -73,8 +75,9 @@ thread_local TlsData g_tls_data;
 // Since asynchronous operations capture device locks, only one asynchronous
 // operation can execute at the same time, on a given device. Tensor operations
 // which send data to device do not need to hold any device locks while doing
-// so. Only operations which _use_ device data (computations, and transfer from
-// server) need to wait for asynchronous operations to complete (barrier).
+// so. The data produced by an asynchronous operation carries its readiness
+// event, and the operations which _use_ device data (computations, and transfer
+// from server) wait only on the events of the data they use.
 
 class DeviceLocker {
  public:
@@ -87,7 +90,7 @@ class DeviceLocker {
 
   void Lock() {
     std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] { return !locked_; });
+    lazy_tensors::env::BlockingWait(&lock, &cv_, [this] { return !locked_; });
     CheckResetException();
     locked_ = true;
   }
@@ -99,13 +102,6 @@ class DeviceLocker {
     cv_.notify_all();
   }
 
-  void Barrier() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] { return !locked_; });
-    cv_.notify_all();
-    CheckResetException();
-  }
-
  private:
   void CheckResetException() {
     std::exception_ptr exptr = std::move(exptr_);
@@ -152,9 +148,147 @@ lazy_tensors::util::ExceptionCleanup LockDevice(const Device& device) {
       });
 }
 
-void DeviceBarrier(const Device& device) {
-  auto locker = DeviceLockerArena::Get()->GetLocker(device);
-  locker->Barrier();
+// Tracks the executions in flight on each device. With LTC_MAX_INFLIGHT_STEPS
+// above 1, the device lock is released as soon as an execution is scheduled
+// instead of once it completes, so that the next steps are traced, compiled and
+// scheduled while the previous ones execute. The executions of a device still
+// run in order, and scheduling waits for the oldest ones beyond the limit.
+class StepPipeline {
+ public:
+  // Accounts the time the host is blocked on the device within its scope.
+  class BlockedSection {
+   public:
+    BlockedSection() : start_ns_(lazy_tensors::sys_util::NowNs()) {
+    }
+
+    ~BlockedSection() {
+      StepPipeline::Get()->blocked_ns_ += lazy_tensors::sys_util::NowNs() - start_ns_;
+    }
+
+   private:
+    int64_t start_ns_;
+  };
+
+  static StepPipeline* Get() {
+    static StepPipeline* pipeline = new StepPipeline();
+    return pipeline;
+  }
+
+  static size_t MaxInflightSteps() {
+    static const size_t max_inflight_steps =
+        std::max<int64_t>(lazy_tensors::sys_util::GetEnvInt("LTC_MAX_INFLIGHT_STEPS", 1), 1);
+    return max_inflight_steps;
+  }
+
+  static bool Enabled() {
+    return MaxInflightSteps() > 1;
+  }
+
+  // Returns the last execution scheduled on the device, which the next one
+  // must follow.
+  lazy_tensors::util::Future<void> Last(const Device& device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = inflight_.find(device);
+    return it != inflight_.end() && !it->second.empty() ? it->second.back()
+                                                         : lazy_tensors::util::Future<void>();
+  }
+
+  // Records an execution scheduled on the device, and waits for the oldest ones
+  // beyond the limit of steps in flight.
+  void Add(const Device& device, lazy_tensors::util::Future<void> done) {
+    RecordOverlap();
+    std::vector<lazy_tensors::util::Future<void>> oldest;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::deque<lazy_tensors::util::Future<void>>& steps = inflight_[device];
+      while (!steps.empty() && steps.front().IsReady()) {
+        steps.pop_front();
+      }
+      steps.push_back(std::move(done));
+      while (steps.size() > MaxInflightSteps()) {
+        oldest.push_back(std::move(steps.front()));
+        steps.pop_front();
+      }
+      LTC_VALUE_METRIC("InflightSteps", steps.size());
+    }
+    if (!oldest.empty()) {
+      BlockedSection blocked;
+      LTC_TIMED("StepBackPressureWait");
+      for (const auto& step : oldest) {
+        step.Wait();
+      }
+    }
+  }
+
+  // Waits for all the executions scheduled on the device.
+  void WaitAll(const Device& device) {
+    std::deque<lazy_tensors::util::Future<void>> steps;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      steps.swap(inflight_[device]);
+    }
+    BlockedSection blocked;
+    for (const auto& step : steps) {
+      step.Wait();
+    }
+  }
+
+  void AddExecutionTime(int64_t execution_ns) {
+    execution_ns_ += execution_ns;
+  }
+
+ private:
+  // Samples the share of the device execution time, since the last step was
+  // scheduled, during which the host was not blocked on the device.
+  void RecordOverlap() {
+    static lazy_tensors::metrics::Metric* blocked_metric = new lazy_tensors::metrics::Metric(
+        "StepHostBlockedTime", lazy_tensors::metrics::MetricFnTime);
+    int64_t execution_ns = execution_ns_.exchange(0);
+    int64_t blocked_ns = blocked_ns_.exchange(0);
+    blocked_metric->AddSample(blocked_ns);
+    if (execution_ns > 0) {
+      LTC_VALUE_METRIC("StepOverlapRatio",
+                       1.0 - static_cast<double>(std::min(blocked_ns, execution_ns)) /
+                                 execution_ns);
+    }
+  }
+
+  std::mutex mutex_;
+  std::map<Device, std::deque<lazy_tensors::util::Future<void>>> inflight_;
+  std::atomic<int64_t> execution_ns_{0};
+  std::atomic<int64_t> blocked_ns_{0};
+};
+
+// Returns the readiness events of the data produced by executions.
+std::vector<lazy_tensors::util::Future<void>> GetReadyEvents(
+    lazy_tensors::Span<const lazy_tensors::ComputationClient::DataPtr> data) {
+  std::vector<lazy_tensors::util::Future<void>> events;
+  for (const auto& handle : data) {
+    if (handle != nullptr) {
+      lazy_tensors::util::Future<void> ready = handle->ready();
+      if (ready.valid()) {
+        events.push_back(std::move(ready));
+      }
+    }
+  }
+  return events;
+}
+
+// Waits for the executions producing the data, and rethrows their exceptions.
+void WaitDataReady(lazy_tensors::Span<const lazy_tensors::ComputationClient::DataPtr> data) {
+  std::vector<lazy_tensors::util::Future<void>> events = GetReadyEvents(data);
+  bool pending = std::any_of(events.begin(), events.end(),
+                             [](const lazy_tensors::util::Future<void>& event) {
+                               return !event.IsReady();
+                             });
+  lazy_tensors::util::Future<void> ready = lazy_tensors::util::WhenAll(std::move(events));
+  if (!pending) {
+    ready.Wait();
+    return;
+  }
+  StepPipeline::BlockedSection blocked;
+  LTC_TIMED("TensorReadyWait");
+  ready.Wait();
 }
 
 // Use a set to impose an order on the device locking sequence (ABBA
@@ -168,12 +302,47 @@ std::vector<lazy_tensors::util::ExceptionCleanup> LockDevices(const std::set<Dev
   return unlocker;
 }
 
+// The number and the size of the blocks sampled to fingerprint a large tensor.
+constexpr int64_t kFingerprintBlocks = 64;
+constexpr int64_t kFingerprintBlockBytes = 64;
+
+int64_t TensorBytes(const at::Tensor& tensor) {
+  return tensor.numel() * tensor.element_size();
+}
+
+// Tensors up to this size are hashed entirely, while larger ones are hashed by
+// a fingerprint of evenly spaced blocks. Cache hits are verified by comparing
+// all the bytes in either case.
+int64_t ExactHashBytes() {
+  static const int64_t exact_hash_bytes =
+      lazy_tensors::sys_util::GetEnvInt("DEVDATA_CACHE_EXACT_HASH_BYTES", 64 * 1024);
+  return exact_hash_bytes;
+}
+
+lazy_tensors::hash_t TensorFingerprint(const at::Tensor& tensor) {
+  int64_t nbytes = TensorBytes(tensor);
+  if (nbytes <= ExactHashBytes() || nbytes <= kFingerprintBlocks * kFingerprintBlockBytes) {
+    return TensorHash(tensor);
+  }
+  at::Tensor ctensor = tensor.contiguous();
+  const char* data = static_cast<const char*>(ctensor.data_ptr());
+  lazy_tensors::hash_t hash =
+      lazy_tensors::util::DataHash(ctensor.sizes().data(), ctensor.dim() * sizeof(int64_t));
+  // The first block is at the start and the last one at the end of the data.
+  int64_t stride = (nbytes - kFingerprintBlockBytes) / (kFingerprintBlocks - 1);
+  for (int64_t i = 0; i < kFingerprintBlocks; ++i) {
+    int64_t offset = i + 1 < kFingerprintBlocks ? i * stride : nbytes - kFingerprintBlockBytes;
+    hash = lazy_tensors::util::HashBlock(data + offset, kFingerprintBlockBytes, hash);
+  }
+  return hash;
+}
+
 class DataCacheArena {
  public:
   struct TensorHasher {
     size_t operator()(const at::Tensor& tensor) const {
       return lazy_tensors::util::HashReduce(lazy_tensors::util::HashCombine(
-          lazy_tensors::util::GetEnumValue(tensor.scalar_type()), TensorHash(tensor)));
+          lazy_tensors::util::GetEnumValue(tensor.scalar_type()), TensorFingerprint(tensor)));
     };
   };
   struct TensorComparer {
@@ -185,47 +354,83 @@ class DataCacheArena {
   using DataCache = lazy_tensors::util::Cache<at::Tensor, lazy_tensors::client::Data, TensorHasher,
                                               TensorComparer>;
 
-  explicit DataCacheArena(size_t max_cache_size) : max_cache_size_(max_cache_size) {
+  // The cache of each device holds up to max_cache_bytes of tensors, or up to
+  // max_cache_size tensors if it is not zero, evicting the least recently used
+  // ones.
+  DataCacheArena(size_t max_cache_bytes, size_t max_cache_size)
+      : max_cache_bytes_(max_cache_bytes), max_cache_size_(max_cache_size) {
   }
 
   DataCache* Get(const Device& device) {
     std::lock_guard<std::mutex> lock(mutex_);
     auto it = device_caches_.find(device);
     if (it == device_caches_.end()) {
-      std::unique_ptr<DataCache> cache(new DataCache(max_cache_size_));
+      auto size_fn = [](const at::Tensor& tensor, const lazy_tensors::client::Data&) {
+        return static_cast<size_t>(TensorBytes(tensor));
+      };
+      std::unique_ptr<DataCache> cache(max_cache_size_ > 0
+                                           ? new DataCache(max_cache_size_)
+                                           : new DataCache(max_cache_bytes_, size_fn));
       it = device_caches_.emplace(device, std::move(cache)).first;
     }
     return it->second.get();
   }
 
+  // Larger tensors would evict too much of the cache, so they are not cached.
+  int64_t max_tensor_bytes() const {
+    return max_cache_bytes_ / 8;
+  }
+
  private:
+  size_t max_cache_bytes_ = 0;
   size_t max_cache_size_ = 0;
   std::mutex mutex_;
   std::map<Device, std::unique_ptr<DataCache>> device_caches_;
 };
 
-DataCacheArena::DataCache* GetDataCache(const Device& device) {
-  static const size_t kMaxCacheSize = lazy_tensors::sys_util::GetEnvInt("DEVDATA_CACHE_SIZE", 128);
-  static DataCacheArena* arena = new DataCacheArena(kMaxCacheSize);
-  return arena->Get(device);
+DataCacheArena* GetDataCacheArena() {
+  static const size_t kMaxCacheBytes =
+      lazy_tensors::sys_util::GetEnvInt("DEVDATA_CACHE_BYTES", 64 * 1024 * 1024);
+  // The former limit on the number of tensors is still honored when set.
+  static const size_t kMaxCacheSize = lazy_tensors::sys_util::GetEnvInt("DEVDATA_CACHE_SIZE", 0);
+  static DataCacheArena* arena = new DataCacheArena(kMaxCacheBytes, kMaxCacheSize);
+  return arena;
 }
 
 ir::Value IrValueFromScalar(const at::Scalar& value, at::ScalarType scalar_type,
                             const Device& device) {
   at::Tensor tensor = at::scalar_tensor(value, at::TensorOptions(scalar_type));
-  lazy_tensors::ComputationClient::DataPtr device_data = TensorToDataHandle(tensor, device);
+  lazy_tensors::ComputationClient::DataPtr device_data = TensorToSharedDataHandle(tensor, device);
   return ir::MakeNode<ir::ops::DeviceData>(std::move(device_data));
 }
 
 lazy_tensors::ComputationClient::DataPtr GetDeviceData(const at::Tensor& tensor,
                                                        const Device& device) {
-  DataCacheArena::DataCache* cache = GetDataCache(device);
+  DataCacheArena* arena = GetDataCacheArena();
+  int64_t nbytes = TensorBytes(tensor);
+  if (nbytes > arena->max_tensor_bytes()) {
+    LTC_COUNTER("DeviceDataCacheSkipped", 1);
+    return TensorToDataHandle(tensor, device);
+  }
+  // The counters are split by how the tensors are hashed.
+  const bool exact_hash = nbytes <= ExactHashBytes();
+  DataCacheArena::DataCache* cache = arena->Get(device);
   lazy_tensors::ComputationClient::DataPtr device_data = cache->Get(tensor);
   if (device_data == nullptr) {
+    // The copy is private and read-only, so the device data can share it with the cache.
     at::Tensor tensor_copy = CopyTensor(tensor);
-    device_data = TensorToDataHandle(tensor_copy, device);
+    device_data = TensorToSharedDataHandle(tensor_copy, device);
     cache->Add(std::move(tensor_copy), device_data);
     LTC_COUNTER("DeviceDataCacheMiss", 1);
+    if (exact_hash) {
+      LTC_COUNTER("DeviceDataCacheMissExact", 1);
+    } else {
+      LTC_COUNTER("DeviceDataCacheMissSampled", 1);
+    }
+  } else if (exact_hash) {
+    LTC_COUNTER("DeviceDataCacheHitExact", 1);
+  } else {
+    LTC_COUNTER("DeviceDataCacheHitSampled", 1);
   }
   return device_data;
 }
@@ -269,6 +474,43 @@ bool TensorsHaveIR(const std::vector<LazyTensor>& tensors) {
   return false;
 }
 
+// The device data being fetched by LazyTensor::PrefetchTensors(). Their buffers
+// are still to be read, so they cannot be donated in the meantime.
+class PendingFetches {
+ public:
+  static PendingFetches* Get() {
+    static PendingFetches* pending_fetches = new PendingFetches();
+    return pending_fetches;
+  }
+
+  void Add(const std::vector<lazy_tensors::ComputationClient::DataPtr>& tensors_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& data : tensors_data) {
+      data_.insert(data.get());
+    }
+  }
+
+  void Remove(const std::vector<lazy_tensors::ComputationClient::DataPtr>& tensors_data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Called from the completion callback of a fetch, which must not throw.
+    for (const auto& data : tensors_data) {
+      auto it = data_.find(data.get());
+      if (it != data_.end()) {
+        data_.erase(it);
+      }
+    }
+  }
+
+  bool Contains(const lazy_tensors::ComputationClient::Data* data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return data_.count(data) > 0;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_multiset<const lazy_tensors::ComputationClient::Data*> data_;
+};
+
 }  // namespace
 
 // The DeviceContextArena holds per device live information and statistics,
@@ -413,8 +655,7 @@ LazyTensor::Async::Async(SyncTensorCollection* coll,
                          std::vector<lazy_tensors::ComputationClient::DataPtr> parameters_data,
                          std::vector<lazy_tensors::ComputationClient::DataPtr> tensors_data,
                          ComputationCache::TypePtr cached_computation)
-    : mwait(1),
-      indices(std::move(coll->indices)),
+    : indices(std::move(coll->indices)),
       unlocker(std::move(coll->unlocker)),
       parameters_data(std::move(parameters_data)),
       device(coll->device.ToString()),
@@ -423,9 +664,8 @@ LazyTensor::Async::Async(SyncTensorCollection* coll,
 }
 
 void LazyTensor::Async::Wait() {
-  mwait.Wait();
-  // Accessing other Async members is safe only after MultiWait::Wait()
-  // completes.
+  done.Wait();
+  // Accessing other Async members is safe only after the execution completes.
   lazy_tensors::util::ExceptionCleanup::StatusType status;
   for (auto& cleanup : unlocker) {
     const lazy_tensors::util::ExceptionCleanup::StatusType& cleanup_status = cleanup.GetStatus();
@@ -565,6 +805,7 @@ lazy_tensors::ComputationClient::DataPtr LazyTensor::GetDataHandle() {
   if (up_to_date) {
     lazy_tensors::ComputationClient::DataPtr handle = CurrentDataHandle();
     if (handle != nullptr) {
+      WaitDataReady({handle});
       LTC_CHECK(handle->HasValue())
           << "Trying to access data while an async operation is in flight: "
           << lazy_tensors::Shape(handle->shape());
@@ -815,9 +1056,9 @@ at::Tensor LazyTensor::ToTensor(bool detached) {
   at::Tensor tensor;
   c10::optional<at::Tensor> tensor_data = CurrentTensorData();
   if (!tensor_data) {
-    DeviceBarrier(GetDevice());
     // The GetDataHandle() call will trigger an ApplyPendingGraph() if an IR
-    // Node is available on the tensor.
+    // Node is available on the tensor, and waits for the execution producing
+    // the data otherwise.
     std::vector<at::Tensor> tensors = DataHandlesToTensors({GetDataHandle()}, dtype());
     tensor = std::move(tensors.front());
     if (!detached) {
@@ -944,12 +1185,52 @@ std::vector<at::Tensor> LazyTensor::GetTensors(std::vector<LazyTensor>* tensors)
   return op_by_op ? GetTensorsOpByOp(tensors) : GetTensorsFused(tensors);
 }
 
+lazy_tensors::util::Future<std::vector<at::Tensor>> LazyTensor::PrefetchTensors(
+    std::vector<LazyTensor>* tensors) {
+  LTC_COUNTER("PrefetchTensors", 1);
+  SyncTensorsConfig config;
+  config.force_ltc_data = false;
+  std::shared_ptr<Async> async = SyncTensorsGraphInternal(tensors, {}, config);
+  // Everything needed from the tensors is captured now, as they may be updated
+  // before their values are fetched.
+  std::vector<lazy_tensors::ComputationClient::DataPtr> tensors_data = GatherTensorsData(
+      *tensors, async != nullptr ? async->indices : lazy_tensors::Span<const size_t>(),
+      async != nullptr ? async->tensors_data
+                       : lazy_tensors::Span<const lazy_tensors::ComputationClient::DataPtr>());
+  std::vector<FetchSource> sources =
+      GetFetchSources(*tensors, async != nullptr ? &async->indices : nullptr);
+
+  PendingFetches::Get()->Add(tensors_data);
+
+  // The fetch is a continuation of the executions producing the data, so no
+  // thread waits for them.
+  lazy_tensors::util::Future<void> executed =
+      lazy_tensors::util::WhenAll(GetReadyEvents(tensors_data));
+  lazy_tensors::util::Future<std::vector<at::Tensor>> future =
+      executed
+          .Then(
+              [async, tensors_data]() {
+                return lazy_tensors::ComputationClient::Get()->TransferFromServerAsync(
+                    tensors_data);
+              },
+              lazy_tensors::util::Executor::kInline, lazy_tensors::env::Priority::kTransfer)
+          .Then(
+              [sources = std::move(sources)](const std::vector<lazy_tensors::Literal>& literals) {
+                return MakeFetchedTensors(sources, literals);
+              },
+              lazy_tensors::util::Executor::kCompute, lazy_tensors::env::Priority::kTransfer);
+  future.OnReady([tensors_data = std::move(tensors_data)]() {
+    PendingFetches::Get()->Remove(tensors_data);
+  });
+  return future;
+}
+
 std::vector<at::Tensor> LazyTensor::GetTensorsFused(std::vector<LazyTensor>* tensors) {
   SyncTensorsConfig config;
   config.force_ltc_data = false;
   auto async = SyncTensorsGraphInternal(tensors, {}, config);
   if (async != nullptr) {
-    async->mwait.Wait();
+    async->done.Wait();
   }
   std::vector<lazy_tensors::ComputationClient::DataPtr> tensors_data = GatherTensorsData(
       *tensors, async != nullptr ? async->indices : lazy_tensors::Span<const size_t>(),
@@ -962,26 +1243,43 @@ std::vector<at::Tensor> LazyTensor::FetchTensors(
     std::vector<LazyTensor>* tensors,
     lazy_tensors::Span<const lazy_tensors::ComputationClient::DataPtr> tensors_data,
     const std::vector<size_t>* indices) {
-  std::vector<at::Tensor> results;
-  size_t literals_index = 0;
+  std::vector<FetchSource> sources = GetFetchSources(*tensors, indices);
+  WaitDataReady(tensors_data);
+  // Transfer all the data in bulk, then make the tensors in order.
+  return MakeFetchedTensors(
+      sources, lazy_tensors::ComputationClient::Get()->TransferFromServer(tensors_data));
+}
+
+std::vector<LazyTensor::FetchSource> LazyTensor::GetFetchSources(
+    const std::vector<LazyTensor>& tensors, const std::vector<size_t>* indices) {
+  std::vector<FetchSource> sources;
   size_t sync_index = 0;
-  results.reserve(tensors->size());
-  for (size_t i = 0; i < tensors->size(); ++i) {
+  sources.reserve(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    FetchSource source;
+    source.dtype = tensors[i].dtype();
     if (indices != nullptr && sync_index < indices->size() && i == (*indices)[sync_index]) {
-      results.push_back(lazy_tensors::MakeTensorFromComputationData(tensors_data[literals_index],
-                                                                    (*tensors)[i].dtype()));
-      ++literals_index;
       ++sync_index;
     } else {
-      c10::optional<at::Tensor> tensor_data = (*tensors)[i].CurrentTensorData();
-      if (tensor_data) {
-        results.push_back(*tensor_data);
-      } else {
-        LTC_CHECK_LT(literals_index, tensors_data.size());
-        results.push_back(lazy_tensors::MakeTensorFromComputationData(tensors_data[literals_index],
-                                                                      (*tensors)[i].dtype()));
-        ++literals_index;
-      }
+      source.tensor_data = tensors[i].CurrentTensorData();
+    }
+    sources.push_back(std::move(source));
+  }
+  return sources;
+}
+
+std::vector<at::Tensor> LazyTensor::MakeFetchedTensors(
+    const std::vector<FetchSource>& sources, const std::vector<lazy_tensors::Literal>& literals) {
+  std::vector<at::Tensor> results;
+  size_t literals_index = 0;
+  results.reserve(sources.size());
+  for (const auto& source : sources) {
+    if (source.tensor_data) {
+      results.push_back(*source.tensor_data);
+    } else {
+      LTC_CHECK_LT(literals_index, literals.size());
+      results.push_back(MakeTensorFromLiteral(literals[literals_index], source.dtype));
+      ++literals_index;
     }
   }
   return results;
@@ -1059,12 +1357,13 @@ LazyTensor LazyTensor::CreateFrom(ir::Value ir_value, const Device& device,
 }
 
 void LazyTensor::ApplyPendingGraph() {
-  DeviceBarrier(GetDevice());
   // This method is called to ensure that the tensor data is available on
   // device, so that a call to CurrentDataHandle() returns a valid pointer.
   if (CurrentDataHandle() == nullptr) {
     std::vector<LazyTensor> tensors({*this});
     SyncTensorsGraph(&tensors, {}, /*wait=*/true, /*sync_ltc_data=*/false);
+  } else {
+    WaitDataReady({CurrentDataHandle()});
   }
 }
 
@@ -1094,6 +1393,7 @@ LazyTensor::SyncTensorCollection LazyTensor::CollectSyncTensors(
   coll.indices.reserve(tensors.size());
   LTC_VLOG(4) << "Waiting on device barrier for device " << coll.device << " ...";
   {
+    StepPipeline::BlockedSection blocked;
     LTC_TIMED("DeviceLockWait");
     coll.unlocker = LockDevices(unique_device.AsSet());
   }
@@ -1257,8 +1557,10 @@ std::shared_ptr<LazyTensor::Async> LazyTensor::ScheduleSyncTensorsGraph(
     try {
       LTC_VLOG(3) << "Executing IR graph hash " << lazy_tensors::util::HexHash(hash)
                   << " on device " << async->device << " ...";
+      int64_t start_ns = lazy_tensors::sys_util::NowNs();
       auto results = lazy_tensors::ComputationClient::Get()->ExecuteComputation(
           *async->cached_computation->computation, async->parameters_data, async->device, options);
+      StepPipeline::Get()->AddExecutionTime(lazy_tensors::sys_util::NowNs() - start_ns);
       LTC_VLOG(3) << "Executing IR graph hash " << lazy_tensors::util::HexHash(hash)
                   << " on device " << async->device << " done!";
 
@@ -1274,20 +1576,51 @@ std::shared_ptr<LazyTensor::Async> LazyTensor::ScheduleSyncTensorsGraph(
       // asynchronous task. One happens if the creator of the asynchronous task
       // explicitly waits for completion, in which case the exception will be
       // thrown from the Wait() API. Re-throwing the exception below makes sure
-      // this will be captured by the completer function created below, and
-      // surfaced by the Wait() API. But we also need to surface the exception
-      // even in case the caller does not wait, and that is accomplished by
-      // setting the unlockers status. In that case the exception will be
-      // surfaced when the user tries to acquire the device locks the next time.
+      // this will be captured by the done future, and surfaced by the Wait()
+      // API. But we also need to surface the exception even in case the caller
+      // does not wait, and that is accomplished by setting the unlockers status
+      // once the done future fails, see below.
+      throw;
+    }
+  };
+
+  // The execution starts once its parameters are produced, and its outputs are
+  // ready once it completes.
+  std::vector<lazy_tensors::util::Future<void>> inputs = GetReadyEvents(async->parameters_data);
+  std::vector<lazy_tensors::util::ExceptionCleanup> unlocker;
+  if (StepPipeline::Enabled()) {
+    // The device is unlocked once the execution is scheduled, after the last
+    // execution of the device. Its failures surface from its outputs.
+    lazy_tensors::util::Future<void> last = StepPipeline::Get()->Last(coll->device);
+    if (last.valid()) {
+      inputs.push_back(std::move(last));
+    }
+    unlocker = std::move(async->unlocker);
+    async->unlocker.clear();
+  }
+  async->done = lazy_tensors::util::WhenAll(std::move(inputs))
+                    .Then(std::move(syncfn), lazy_tensors::util::Executor::kIo,
+                          lazy_tensors::env::Priority::kExecution);
+  // The execution fails either by itself, or because the producer of one of
+  // its parameters failed, in which case syncfn does not run. Either way, the
+  // exception is surfaced when the user tries to acquire the device locks the
+  // next time.
+  async->done.OnReady([async]() {
+    try {
+      async->done.Wait();
+    } catch (...) {
       std::exception_ptr exptr = std::current_exception();
       for (auto& unlocker : async->unlocker) {
         unlocker.SetStatus(exptr);
       }
-      throw;
     }
-  };
-
-  lazy_tensors::env::ScheduleIoClosure(async->mwait.Completer(std::move(syncfn)));
+  });
+  for (auto& data : async->tensors_data) {
+    if (data != nullptr) {
+      data->SetReady(async->done);
+    }
+  }
+  StepPipeline::Get()->Add(coll->device, async->done);
   return async;
 }
 
@@ -1302,11 +1635,12 @@ std::shared_ptr<LazyTensor::Async> LazyTensor::ScheduleSyncTensorsGraph(
 
 void LazyTensor::SyncTensorsGraph(std::vector<LazyTensor>* tensors,
                                   lazy_tensors::Span<const std::string> devices, bool wait,
-                                  bool sync_ltc_data) {
+                                  bool sync_ltc_data, bool live_tensors) {
   LTC_VLOG(4) << "Trying to get the value of " << tensors->size() << " tensor(s)";
   static const bool op_by_op = lazy_tensors::sys_util::GetEnvBool("SYNC_TENSORS_OPBYOP", false);
   SyncTensorsConfig config;
   config.sync_ltc_data = sync_ltc_data;
+  config.live_tensors = live_tensors;
   if (op_by_op) {
     OpByOpAsync async = SyncTensorsGraphOpByOp(tensors, devices, config);
     if (wait) {
@@ -1315,7 +1649,7 @@ void LazyTensor::SyncTensorsGraph(std::vector<LazyTensor>* tensors,
   } else {
     auto async = SyncTensorsGraphInternal(tensors, devices, config);
     if (wait && async != nullptr) {
-      async->mwait.Wait();
+      async->done.Wait();
     }
   }
 }
@@ -1324,7 +1658,7 @@ void LazyTensor::SyncLiveTensorsGraph(const Device* device,
                                       lazy_tensors::Span<const std::string> devices, bool wait) {
   auto tensors = GetLiveTensors(device);
   LTC_VLOG(4) << tensors.size() << " live tensors: devices=(" << absl::StrJoin(devices, ",") << ")";
-  SyncTensorsGraph(&tensors, devices, wait, /*sync_ltc_data=*/true);
+  SyncTensorsGraph(&tensors, devices, wait, /*sync_ltc_data=*/true, /*live_tensors=*/true);
 }
 
 void LazyTensor::MarkStep(const Device& device) {
@@ -1349,6 +1683,10 @@ void LazyTensor::WaitDeviceOps(lazy_tensors::Span<const std::string> devices) {
   // lazy_tensors::util::ExceptionCleanup object, which is going to be freed
   // immediately, turning this operation into a lock barrier.
   LockDevices(wait_devices);
+  // The executions still in flight once their devices are unlocked.
+  for (const auto& device : wait_devices) {
+    StepPipeline::Get()->WaitAll(device);
+  }
 }
 
 LazyTensor::OpByOpAsync LazyTensor::SyncTensorsGraphOpByOp(
@@ -1377,8 +1715,14 @@ LazyTensor::OpByOpAsync LazyTensor::SyncTensorsGraphOpByOp(
   auto tensors_data = FetchTensorData(tensors, coll.config, coll.indices);
   auto async =
       std::make_shared<Async>(std::move(coll), std::move(tensors_data), std::move(roots), devices);
+  lazy_tensors::util::Promise<void> done;
+  for (auto& data : async->tensors_data) {
+    if (data != nullptr) {
+      data->SetReady(done.GetFuture());
+    }
+  }
 
-  auto syncfn = [async]() -> int {
+  auto syncfn = [async, done]() -> int {
     try {
       LTC_VLOG(3) << "Executing (OpByOp) IR graph hash "
                   << lazy_tensors::util::HexHash(async->coll.hash) << " on device "
@@ -1400,16 +1744,130 @@ LazyTensor::OpByOpAsync LazyTensor::SyncTensorsGraphOpByOp(
       for (auto& unlocker : async->coll.unlocker) {
         unlocker.SetStatus(exptr);
       }
+      done.SetException(exptr);
       throw;
     }
+    done.SetValue();
     return 0;
   };
   OpByOpAsync async_op(std::move(syncfn));
   return async_op.Schedule();
 }
 
+void LazyTensor::AnalyzeDonations(const std::vector<LazyTensor>& tensors,
+                                  SyncTensorCollection* coll, PostOrderData* po_data) {
+  const std::vector<lazy_tensors::ComputationClient::DataPtr>& parameters_data =
+      po_data->parameters_data;
+  po_data->donatable_parameters.assign(parameters_data.size(), false);
+  std::unordered_set<int64_t> output_tensor_ids;
+  for (auto index : coll->indices) {
+    output_tensor_ids.insert(tensors[index].GetUniqueId());
+  }
+  // The parameters which are updated by one of the outputs, keyed by buffer.
+  std::unordered_map<lazy_tensors::client::Data::OpaqueHandle, size_t> updated_parameters;
+  for (size_t i = 0; i < parameters_data.size(); ++i) {
+    DeviceDataInfo* data_info = dynamic_cast<DeviceDataInfo*>(parameters_data[i]->info());
+    if (data_info != nullptr && !data_info->read_only &&
+        output_tensor_ids.count(data_info->tensor_id) > 0) {
+      updated_parameters.emplace(parameters_data[i]->GetOpaqueHandle(), i);
+    }
+  }
+  if (updated_parameters.empty()) {
+    return;
+  }
+
+  // We can only alias at the step barrier, see LazyTensor::Compile().
+  const bool enable_aliasing = lazy_tensors::sys_util::GetEnvBool("ENABLE_PARAM_ALIASING", true);
+  std::unordered_set<size_t> referenced_parameters;
+  if (enable_aliasing && coll->config.sync_ltc_data && coll->config.force_ltc_data) {
+    // The tensors synced by this graph read the parameters before they are
+    // updated. Any other live tensor reading a buffer after the update blocks
+    // its donation, either because it holds the buffer as its data, or because
+    // it has a pending IR graph (including its view) on top of the buffer.
+    // When syncing the live tensors, e.g. at the step barrier, they are the
+    // synced tensors, so that the others only hold device data.
+    std::vector<LazyTensor> device_tensors;
+    if (!coll->config.live_tensors) {
+      device_tensors = GetLiveTensors(&coll->device);
+    }
+    const std::vector<LazyTensor>& live_tensors =
+        coll->config.live_tensors ? tensors : device_tensors;
+    std::vector<ir::Value> pending_ir_values;
+    for (const auto& tensor : live_tensors) {
+      if (referenced_parameters.size() == updated_parameters.size()) {
+        // Every updated parameter is copied anyway.
+        pending_ir_values.clear();
+        break;
+      }
+      if (output_tensor_ids.count(tensor.GetUniqueId()) > 0) {
+        continue;
+      }
+      lazy_tensors::ComputationClient::DataPtr handle = tensor.CurrentDataHandle();
+      if (handle != nullptr) {
+        auto it = updated_parameters.find(handle->GetOpaqueHandle());
+        if (it != updated_parameters.end()) {
+          referenced_parameters.insert(it->second);
+        }
+      }
+      ir::Value ir_value = tensor.CurrentIrValue();
+      if (ir_value) {
+        pending_ir_values.push_back(std::move(ir_value));
+      }
+    }
+    if (!pending_ir_values.empty()) {
+      std::vector<const ir::Node*> roots;
+      for (const auto& ir_value : pending_ir_values) {
+        roots.push_back(ir_value.node.get());
+      }
+      ir::Util::EmissionMap emission_map;
+      for (auto node : ir::Util::ComputePostOrder(roots, &emission_map)) {
+        const ir::ops::DeviceData* device_data = ir::ops::DeviceData::Cast(node);
+        if (device_data != nullptr) {
+          auto it = updated_parameters.find(device_data->data()->GetOpaqueHandle());
+          if (it != updated_parameters.end()) {
+            referenced_parameters.insert(it->second);
+          }
+        }
+      }
+    }
+    for (const auto& handle_index : updated_parameters) {
+      if (PendingFetches::Get()->Contains(parameters_data[handle_index.second].get())) {
+        referenced_parameters.insert(handle_index.second);
+      }
+    }
+  } else {
+    for (const auto& handle_index : updated_parameters) {
+      referenced_parameters.insert(handle_index.second);
+    }
+  }
+
+  std::vector<size_t> donated_parameters;
+  int64_t donated_bytes = 0;
+  int64_t copied_bytes = 0;
+  for (size_t i = 0; i < parameters_data.size(); ++i) {
+    if (updated_parameters.count(parameters_data[i]->GetOpaqueHandle()) == 0) {
+      continue;
+    }
+    lazy_tensors::Shape shape(parameters_data[i]->shape());
+    int64_t nbytes = lazy_tensors::ShapeUtil::ElementsIn(shape) *
+                     lazy_tensors::ShapeUtil::ByteSizeOfPrimitiveType(shape.element_type());
+    if (referenced_parameters.count(i) > 0) {
+      copied_bytes += nbytes;
+    } else {
+      po_data->donatable_parameters[i] = true;
+      donated_parameters.push_back(i);
+      donated_bytes += nbytes;
+    }
+  }
+  LTC_COUNTER("InputOutputDonatedBytes", donated_bytes);
+  LTC_COUNTER("InputOutputCopiedBytes", copied_bytes);
+  coll->hash =
+      lazy_tensors::util::HashCombine(coll->hash, lazy_tensors::util::Hash(donated_parameters));
+}
+
 void LazyTensor::BuildInputOutputAliases(const std::vector<LazyTensor>& tensors,
                                          lazy_tensors::Span<const size_t> indices,
+                                         const std::vector<bool>& donatable_parameters,
                                          ir::LoweringContext* lowering_ctx) {
   std::unordered_map<int64_t, size_t> output_tensor_id_map;
   for (size_t i = 0; i < indices.size(); ++i) {
@@ -1422,7 +1880,7 @@ void LazyTensor::BuildInputOutputAliases(const std::vector<LazyTensor>& tensors,
   std::vector<ssize_t> alias_map(indices.size(), -1);
   for (size_t i = 0; i < parameters_data.size(); ++i) {
     DeviceDataInfo* data_info = dynamic_cast<DeviceDataInfo*>(parameters_data[i]->info());
-    if (data_info != nullptr && !data_info->read_only) {
+    if (data_info != nullptr && !data_info->read_only && donatable_parameters[i]) {
       auto it = output_tensor_id_map.find(data_info->tensor_id);
       if (it != output_tensor_id_map.end()) {
         size_t output_index = it->second;
@@ -1445,14 +1903,14 @@ LazyTensor::CompilationResult LazyTensor::Compile(const std::vector<LazyTensor>&
                                                   lazy_tensors::Span<const std::string> devices,
                                                   const SyncTensorCollection& coll,
                                                   PostOrderData* po_data) {
-  const bool enable_aliasing = lazy_tensors::sys_util::GetEnvBool("ENABLE_PARAM_ALIASING", false);
+  const bool enable_aliasing = lazy_tensors::sys_util::GetEnvBool("ENABLE_PARAM_ALIASING", true);
   auto lowering_ctx = ir::LoweringContext::Create(
       "SyncTensorsGraph", coll.device, po_data->post_order, std::move(po_data->emission_map));
   for (auto index : coll.indices) {
     ir::Value ir_value = tensors[index].CurrentIrValue();
     lowering_ctx->AddResult(ir_value);
   }
-  if (enable_aliasing && coll.config.sync_ltc_data) {
+  if (enable_aliasing && coll.config.sync_ltc_data && coll.config.force_ltc_data) {
     // We can only alias at the step barrier, when force_ltc_data is true.
     // Consider the case:
     //   1. Tensor A(DEVICE_DATA)
@@ -1477,7 +1935,10 @@ LazyTensor::CompilationResult LazyTensor::Compile(const std::vector<LazyTensor>&
     // will later fetch the new value of A, which is incorrect.
     // But, when we issue a step barrier (force_ltc_data == true) we have to
     // turn everything into DEVICE_DATA, so we can activate aliasing.
-    BuildInputOutputAliases(tensors, coll.indices, lowering_ctx.get());
+    // Buffers still referenced by other live tensors are not donated, see
+    // LazyTensor::AnalyzeDonations().
+    BuildInputOutputAliases(tensors, coll.indices, po_data->donatable_parameters,
+                            lowering_ctx.get());
   }
 
   auto computation = ConsumeValue(lowering_ctx->Build());
@@ -1518,6 +1979,7 @@ std::shared_ptr<LazyTensor::Async> LazyTensor::SyncTensorsGraphInternal(
   coll.hash = lazy_tensors::util::HashCombine(coll.hash,
                                               lazy_tensors::util::Hash(po_data.parameter_sequence));
   LTC_VLOG(4) << "Parameter sequence graph hash " << lazy_tensors::util::HexHash(coll.hash);
+  AnalyzeDonations(*tensors, &coll, &po_data);
   std::shared_ptr<Async> async = TryRunCachedSync(tensors, &coll, &po_data);
   if (async != nullptr) {
     return async;
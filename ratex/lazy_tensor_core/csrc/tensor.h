@@ -21,7 +21,7 @@
 #include "lazy_tensors/computation_client/async_task.h"
 #include "lazy_tensors/computation_client/cache.h"
 #include "lazy_tensors/computation_client/computation_client.h"
-#include "lazy_tensors/computation_client/multi_wait.h"
+#include "lazy_tensors/computation_client/future.h"
 #include "lazy_tensors/computation_client/util.h"
 #include "lazy_tensors/status.h"
 #include "lazy_tensors/types.h"
@@ -165,9 +165,10 @@ class LazyTensor {
   // the tensors must be on the same device. If wait is true, the sync operation
   // will be run synchronously. The devices argument, if not empty, tells the
   // devices which should be partecipating into the replicated computation.
+  // The live_tensors argument tells whether the tensors are all the live ones.
   static void SyncTensorsGraph(std::vector<LazyTensor>* tensors,
                                lazy_tensors::Span<const std::string> devices, bool wait,
-                               bool sync_ltc_data);
+                               bool sync_ltc_data, bool live_tensors = false);
 
   // Makes sure that any outstanding IR operation accumulated over live tensors,
   // gets turned into device data. If wait is true, the sync operation will be
@@ -188,6 +189,12 @@ class LazyTensor {
   // All the tensors must be on the same device.
   static std::vector<at::Tensor> GetTensors(std::vector<LazyTensor>* tensors);
 
+  // Like GetTensors(), but without waiting for the pending IR operations: the
+  // values are fetched right behind their execution, and the returned future
+  // is ready once they are on the host.
+  static lazy_tensors::util::Future<std::vector<at::Tensor>> PrefetchTensors(
+      std::vector<LazyTensor>* tensors);
+
   // Operation which creates lazy tensors out of PyTorch CPU tensors by batching
   // the requests to the computation servers.
   static std::vector<LazyTensor> CreateTensors(const std::vector<at::Tensor>& tensors,
@@ -230,7 +237,7 @@ class LazyTensor {
 
   static std::pair<LazyTensor, ir::Value> collective_permute(
       const LazyTensor& input, const ir::Value& token,
-      std::vector<std::pair<int64_t, int64_t>> source_target_pairs);
+      std::vector<std::pair<int64_t, int64_t>> source_target_pairs, int64_t rank);
 
   static LazyTensor get_dimensions_size(const LazyTensor& input, std::vector<int64_t> dimensions);
 
@@ -995,6 +1002,9 @@ class LazyTensor {
     // Whether when setting the data, the other properties of the tensor
     // state should be reset.
     bool sync_ltc_data = true;
+    // Whether the tensors are all the live tensors, which the donation
+    // analysis then does not need to collect again.
+    bool live_tensors = false;
   };
 
   struct SyncTensorCollection {
@@ -1013,6 +1023,9 @@ class LazyTensor {
     ir::Util::EmissionMap emission_map;
     std::vector<lazy_tensors::ComputationClient::DataPtr> parameters_data;
     std::vector<size_t> parameter_sequence;
+    // Whether the buffer of each parameter can be donated to the output which
+    // updates it, as proven by AnalyzeDonations().
+    std::vector<bool> donatable_parameters;
   };
 
   struct CompilationResult {
@@ -1030,7 +1043,8 @@ class LazyTensor {
 
     void Wait();
 
-    lazy_tensors::util::MultiWait mwait;
+    // Ready once the graph is executed and the outputs are assigned.
+    lazy_tensors::util::Future<void> done;
     std::vector<size_t> indices;
     std::vector<lazy_tensors::util::ExceptionCleanup> unlocker;
     std::vector<lazy_tensors::ComputationClient::DataPtr> parameters_data;
@@ -1178,6 +1192,20 @@ class LazyTensor {
       lazy_tensors::Span<const lazy_tensors::ComputationClient::DataPtr> tensors_data,
       const std::vector<size_t>* indices);
 
+  // Where the fetched value of a tensor comes from: the tensor data it already
+  // holds on the host, or otherwise the next of the transferred literals.
+  struct FetchSource {
+    c10::optional<at::Tensor> tensor_data;
+    at::ScalarType dtype;
+  };
+
+  static std::vector<FetchSource> GetFetchSources(const std::vector<LazyTensor>& tensors,
+                                                  const std::vector<size_t>* indices);
+
+  static std::vector<at::Tensor> MakeFetchedTensors(
+      const std::vector<FetchSource>& sources,
+      const std::vector<lazy_tensors::Literal>& literals);
+
   // Schedules the execution of a sync tensors operation in background. The
   // asynchronous operation will hold the device locks by capturing the ones
   // present within the coll structure.
@@ -1202,8 +1230,17 @@ class LazyTensor {
                                                  SyncTensorCollection* coll,
                                                  PostOrderData* po_data);
 
+  // Finds the parameters whose device buffers can be donated to the outputs
+  // updating them. A buffer is donated only if no live tensor, other than the
+  // one being updated, holds it or has a pending IR graph reading it. The
+  // decision is mixed into the collection hash, as it changes the compiled
+  // aliases.
+  static void AnalyzeDonations(const std::vector<LazyTensor>& tensors,
+                               SyncTensorCollection* coll, PostOrderData* po_data);
+
   static void BuildInputOutputAliases(const std::vector<LazyTensor>& tensors,
                                       lazy_tensors::Span<const size_t> indices,
+                                      const std::vector<bool>& donatable_parameters,
                                       ir::LoweringContext* lowering_ctx);
 
   static CompilationResult Compile(const std::vector<LazyTensor>& tensors,
@@ -387,9 +387,9 @@ LazyTensor LazyTensor::get_dimensions_size(const LazyTensor& input,
 
 std::pair<LazyTensor, ir::Value> LazyTensor::collective_permute(
     const LazyTensor& input, const ir::Value& token,
-    std::vector<std::pair<int64_t, int64_t>> source_target_pairs) {
-  ir::NodePtr node = ir::MakeNode<ir::ops::CollectivePermute>(input.GetIrValue(), token,
-                                                              std::move(source_target_pairs));
+    std::vector<std::pair<int64_t, int64_t>> source_target_pairs, int64_t rank) {
+  ir::NodePtr node = ir::MakeNode<ir::ops::CollectivePermute>(
+      input.GetIrValue(), token, std::move(source_target_pairs), rank);
   return {input.CreateFrom(ir::Value(node, 0)), ir::Value(node, 1)};
 }
 
@@ -8,16 +8,19 @@
 #include "lazy_tensor_core/csrc/tensor_util.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <functional>
 #include <list>
 #include <numeric>
 #include <thread>
+#include <type_traits>
 
 #include "lazy_tensor_core/csrc/helpers.h"
 #include "lazy_tensor_core/csrc/layout_manager.h"
 #include "lazy_tensors/computation_client/debug_macros.h"
 #include "lazy_tensors/computation_client/ltc_logging.h"
+#include "lazy_tensors/computation_client/metrics.h"
 #include "lazy_tensors/computation_client/multi_wait.h"
 #include "lazy_tensors/computation_client/nnc_computation_client.h"
 #include "lazy_tensors/computation_client/sys_util.h"
@@ -190,6 +193,17 @@ struct Caster<std::complex<double>> {
   }
 };
 
+template <>
+c10::complex<float> Caster<std::complex<double>>::cast<c10::complex<float>>(
+    const std::complex<double>& value) const {
+  return c10::complex<float>(value.real(), value.imag());
+}
+template <>
+c10::complex<double> Caster<std::complex<double>>::cast<c10::complex<double>>(
+    const std::complex<double>& value) const {
+  return c10::complex<double>(value.real(), value.imag());
+}
+
 // Copies n bytes from source to dest, with different stride values for source
 // and destination.
 template <typename S, typename D>
@@ -261,22 +275,101 @@ void CheckedMemcpy(D* dest, const S* source, int64_t n) {
   std::memcpy(dest, source, n * sizeof(S));
 }
 
+// Whether the S and D types have the same binary representation, in which case
+// copying is a memcpy().
+template <typename S, typename D>
+struct SameRepresentation {
+  static constexpr bool value = std::is_same<S, D>::value;
+};
+template <typename T>
+struct SameRepresentation<std::complex<T>, c10::complex<T>> {
+  static constexpr bool value = true;
+};
+template <typename T>
+struct SameRepresentation<c10::complex<T>, std::complex<T>> {
+  static constexpr bool value = true;
+};
+
 template <typename D, typename S>
 void CopyData(D* dest, const S* source, int64_t n, const CopyDirect&) {
+  // The integer widening and narrowing, and the conversions from/to bool, are
+  // plain loops which the compiler vectorizes.
   std::copy(source, source + n, dest);
 }
 
 template <typename D, typename S>
 void CopyData(D* dest, const S* source, int64_t n, const CopyCasted&) {
-  // Use strided copy with step 1 since it has the static_cast<> required to
-  // convert from/to bfloat16.
-  StridedCopy(dest, 1, source, 1, n);
+  if constexpr (SameRepresentation<S, D>::value) {
+    CheckedMemcpy<D, S>(dest, source, n);
+  } else {
+    Caster<S> caster;
+    for (int64_t i = 0; i < n; ++i) {
+      dest[i] = caster.template cast<D>(source[i]);
+    }
+  }
+}
+
+// The conversions between F32 and the 16 bits floating point types work on the
+// bit patterns with branch-free loops, which the compiler vectorizes, instead
+// of calling the scalar at::BFloat16 and at::Half conversion operators.
+template <>
+void CopyData<at::BFloat16, float>(at::BFloat16* dest, const float* source, int64_t n,
+                                   const CopyCasted&) {
+  for (int64_t i = 0; i < n; ++i) {
+    uint32_t bits;
+    std::memcpy(&bits, source + i, sizeof(bits));
+    // Round to nearest even like c10::BFloat16, with NaNs made quiet.
+    uint32_t rounded = (bits + ((bits >> 16) & 1) + 0x7fff) >> 16;
+    dest[i].x = std::isnan(source[i]) ? 0x7fc0 : static_cast<uint16_t>(rounded);
+  }
+}
+
+template <>
+void CopyData<float, at::BFloat16>(float* dest, const at::BFloat16* source, int64_t n,
+                                   const CopyCasted&) {
+  for (int64_t i = 0; i < n; ++i) {
+    uint32_t bits = static_cast<uint32_t>(source[i].x) << 16;
+    std::memcpy(dest + i, &bits, sizeof(bits));
+  }
+}
+
+template <>
+void CopyData<at::Half, float>(at::Half* dest, const float* source, int64_t n, const CopyCasted&) {
+  for (int64_t i = 0; i < n; ++i) {
+    dest[i].x = c10::detail::fp16_ieee_from_fp32_value(source[i]);
+  }
 }
 
 template <>
-void CopyData<at::BFloat16, at::BFloat16>(at::BFloat16* dest, const at::BFloat16* source, int64_t n,
-                                          const CopyCasted&) {
-  CheckedMemcpy<at::BFloat16, at::BFloat16>(dest, source, n);
+void CopyData<float, at::Half>(float* dest, const at::Half* source, int64_t n, const CopyCasted&) {
+  for (int64_t i = 0; i < n; ++i) {
+    dest[i] = c10::detail::fp16_ieee_to_fp32_value(source[i].x);
+  }
+}
+
+// The minimum number of bytes (read plus written) copied by a thread.
+constexpr int64_t kMinThreadCopyBytes = 1 << 20;
+
+// Returns the number of threads copying the given bytes: one every
+// kMinThreadCopyBytes, up to the number of cores.
+int64_t GetCopyParallelism(int64_t nbytes) {
+  static const int64_t max_parts = std::max<int64_t>(std::thread::hardware_concurrency(), 1);
+  return std::max<int64_t>(std::min<int64_t>(nbytes / kMinThreadCopyBytes, max_parts), 1);
+}
+
+// Runs part_fn(i) for each of the num_parts parts of a copy, on the thread pool
+// unless there is a single part.
+void RunCopyParts(int64_t num_parts, const std::function<void(int64_t)>& part_fn) {
+  if (num_parts == 1) {
+    part_fn(0);
+    return;
+  }
+  auto mwait = std::make_shared<lazy_tensors::util::MultiWait>(num_parts);
+  for (int64_t i = 0; i < num_parts; ++i) {
+    lazy_tensors::env::ScheduleClosure(
+        lazy_tensors::util::MultiWait::Completer(mwait, [&part_fn, i]() { part_fn(i); }));
+  }
+  mwait->Wait();
 }
 
 std::vector<int64_t> GetIterationDimensions(const lazy_tensors::Shape& shape) {
@@ -312,11 +405,12 @@ struct CopyPartition {
 };
 
 std::vector<CopyPartition> CreateCopyPartitions(lazy_tensors::Span<const int64_t> dimensions,
-                                                int64_t strided_copy_dimension) {
+                                                int64_t strided_copy_dimension,
+                                                int64_t element_bytes) {
+  int64_t num_elements = lazy_tensors::util::Multiply<int64_t>(dimensions);
+  int64_t max_parts = GetCopyParallelism(num_elements * element_bytes);
   // The minimum number of elements copy that can be assigned to a thread.
-  static const int64_t kMinThreadElements = 100000;
-  // Use at most 50% of the available cores.
-  int64_t max_parts = std::max<int64_t>(std::thread::hardware_concurrency() / 2, 1);
+  int64_t min_thread_elements = kMinThreadCopyBytes / element_bytes;
   // Find the maximum dimension which is not the strided copy dimension.
   int64_t max_dim = -1;
   for (int64_t i = 0; i < dimensions.size(); ++i) {
@@ -325,11 +419,10 @@ std::vector<CopyPartition> CreateCopyPartitions(lazy_tensors::Span<const int64_t
     }
   }
 
-  int64_t num_elements = lazy_tensors::util::Multiply<int64_t>(dimensions);
   int64_t max_dim_unit_elements = num_elements / dimensions[max_dim];
   int64_t max_dim_size = dimensions[max_dim];
   int64_t part_size = std::max<int64_t>(std::max<int64_t>(max_dim_size / max_parts, 1),
-                                        kMinThreadElements / max_dim_unit_elements);
+                                        min_thread_elements / max_dim_unit_elements);
   std::vector<CopyPartition> parts;
   int64_t csize = 0;
   while (csize < max_dim_size) {
@@ -378,10 +471,18 @@ void CopyTensors(const void* src_buffer, const lazy_tensors::Shape& src_shape, v
 
   const SType* src_data = reinterpret_cast<const SType*>(src_buffer);
   DType* dest_data = reinterpret_cast<DType*>(dest_buffer);
+  // Both the same layout and the transposing copies are split across threads
+  // by the bytes they move.
+  int64_t element_bytes = sizeof(SType) + sizeof(DType);
   if (src_shape.layout().minor_to_major() == dest_shape.layout().minor_to_major()) {
-    CopyData<DType, SType>(
-        dest_data, src_data, total_elements,
-        typename CopyType < NeedCast<SType>::value || NeedCast<DType>::value > ::type());
+    int64_t num_parts = GetCopyParallelism(total_elements * element_bytes);
+    RunCopyParts(num_parts, [&](int64_t i) {
+      int64_t start = total_elements * i / num_parts;
+      int64_t end = total_elements * (i + 1) / num_parts;
+      CopyData<DType, SType>(
+          dest_data + start, src_data + start, end - start,
+          typename CopyType < NeedCast<SType>::value || NeedCast<DType>::value > ::type());
+    });
   } else if (total_elements > 0) {
     // We issue a multi-threaded copy by slicing the bigger dimension and
     // assigning its copy to different threads. This code is only valid for
@@ -390,17 +491,11 @@ void CopyTensors(const void* src_buffer, const lazy_tensors::Shape& src_shape, v
     std::vector<int64_t> dest_strides = ComputeShapeStrides(dest_shape);
     std::vector<int64_t> iter_dims = GetIterationDimensions(dest_shape);
     std::vector<CopyPartition> parts =
-        CreateCopyPartitions(dest_shape.dimensions(), iter_dims.front());
-    auto mwait = std::make_shared<lazy_tensors::util::MultiWait>(parts.size());
-    for (size_t i = 0; i < parts.size(); ++i) {
-      auto copy_fn = [&, i]() {
-        SlicedCopy<SType, DType>(dest_shape.dimensions(), src_data, src_strides, dest_data,
-                                 dest_strides, iter_dims, parts[i]);
-      };
-      lazy_tensors::env::ScheduleClosure(
-          lazy_tensors::util::MultiWait::Completer(mwait, std::move(copy_fn)));
-    }
-    mwait->Wait();
+        CreateCopyPartitions(dest_shape.dimensions(), iter_dims.front(), element_bytes);
+    RunCopyParts(parts.size(), [&](int64_t i) {
+      SlicedCopy<SType, DType>(dest_shape.dimensions(), src_data, src_strides, dest_data,
+                               dest_strides, iter_dims, parts[i]);
+    });
   }
 }
 
@@ -448,7 +543,7 @@ void TensorToBufferSType(const at::Tensor& tensor, const lazy_tensors::Shape& de
       TensorToBuffer<SType, uint16_t>(tensor, dest_shape, dest_buffer, dest_buffer_size, device);
       break;
     case lazy_tensors::PrimitiveType::S32:
-      TensorToBuffer<SType, int16_t>(tensor, dest_shape, dest_buffer, dest_buffer_size, device);
+      TensorToBuffer<SType, int32_t>(tensor, dest_shape, dest_buffer, dest_buffer_size, device);
       break;
     case lazy_tensors::PrimitiveType::U32:
       TensorToBuffer<SType, uint32_t>(tensor, dest_shape, dest_buffer, dest_buffer_size, device);
@@ -464,8 +559,8 @@ void TensorToBufferSType(const at::Tensor& tensor, const lazy_tensors::Shape& de
                                                  device);
       break;
     case lazy_tensors::PrimitiveType::C128:
-      TensorToBuffer<SType, std::complex<float>>(tensor, dest_shape, dest_buffer, dest_buffer_size,
-                                                 device);
+      TensorToBuffer<SType, std::complex<double>>(tensor, dest_shape, dest_buffer, dest_buffer_size,
+                                                  device);
       break;
     default:
       LTC_ERROR() << "Destination shape type not supported: " << dest_shape;
@@ -497,6 +592,12 @@ at::Tensor LiteralToTensor(const lazy_tensors::Literal& literal, at::ScalarType
   lazy_tensors::Shape torch_shape = MakeTorchTensorLayout(
       literal.shape().dimensions(), /*dynamic_dimensions=*/{}, literal.shape().element_type());
   int64_t total_elements = lazy_tensors::ShapeUtil::ElementsIn(torch_shape);
+  if (std::is_same<SType, DType>::value && !literal.is_borrowed() &&
+      literal.shape().layout().minor_to_major() == torch_shape.layout().minor_to_major()) {
+    // The literal storage is private and already in the PyTorch layout: use it as is.
+    LTC_COUNTER("LiteralToTensorZeroCopy", 1);
+    return literal.value();
+  }
 
   const auto literal_data = literal.data<SType>();
   at::Tensor tensor = at::empty(dimensions, at::TensorOptions(atype));
@@ -636,7 +737,7 @@ at::Tensor MakeTensorFromLiteral(const lazy_tensors::Literal& literal,
     case lazy_tensors::PrimitiveType::C64:
       return LiteralToTensorHelper<std::complex<float>>(literal, dest_element_type);
     case lazy_tensors::PrimitiveType::C128:
-      return LiteralToTensorHelper<std::complex<float>>(literal, dest_element_type);
+      return LiteralToTensorHelper<std::complex<double>>(literal, dest_element_type);
     default:
       LTC_ERROR() << "Unsupported literal type: " << literal.shape();
   }
@@ -660,17 +761,50 @@ lazy_tensors::ComputationClient::DataPtr TensorToDataHandle(const at::Tensor& te
   return TensorToDataHandle(tensor, CreateComputationShapeFromTensor(tensor, &device), device);
 }
 
+lazy_tensors::ComputationClient::DataPtr TensorToSharedDataHandle(const at::Tensor& tensor,
+                                                                  const Device& device) {
+  lazy_tensors::Shape shape = CreateComputationShapeFromTensor(tensor, &device);
+  auto populate_fn = [&](const lazy_tensors::ComputationClient::TensorSource& source_tensor,
+                         void* dest_buffer, size_t dest_buffer_size) {
+    PopulateTensorBuffer(tensor, source_tensor.shape, dest_buffer, dest_buffer_size, device);
+  };
+  std::vector<lazy_tensors::ComputationClient::TensorSource> source_tensors;
+  source_tensors.emplace_back(lazy_tensors::ToShapeData(shape), device.ToString(),
+                              std::move(populate_fn));
+  lazy_tensors::Shape torch_shape =
+      MakeTorchTensorLayout(shape.dimensions(), /*dynamic_dimensions=*/{}, shape.element_type());
+  if (tensor.is_contiguous() &&
+      tensor.scalar_type() == lazy_tensors::PrimitiveToScalarType(shape.element_type()) &&
+      shape.layout().minor_to_major() == torch_shape.layout().minor_to_major()) {
+    source_tensors.front().data = tensor.data_ptr();
+    source_tensors.front().data_owner = std::make_shared<at::Tensor>(tensor);
+  }
+  auto handles = lazy_tensors::ComputationClient::Get()->TransferToServer(source_tensors);
+  LTC_CHECK_EQ(handles.size(), 1);
+  return std::move(handles.front());
+}
+
 std::vector<lazy_tensors::ComputationClient::DataPtr> CreateTensorsData(
     const std::vector<at::Tensor>& tensors, const std::vector<std::string>& devices) {
   LTC_CHECK_EQ(tensors.size(), devices.size());
-  std::vector<lazy_tensors::ComputationClient::DataPtr> result;
-  result.reserve(tensors.size());
+  // Issue a single transfer for all the tensors, so that the client can batch and parallelize
+  // them. The returned handles are in the order of the tensors.
+  std::vector<lazy_tensors::ComputationClient::TensorSource> source_tensors;
+  source_tensors.reserve(tensors.size());
   for (size_t i = 0; i < tensors.size(); ++i) {
     Device device(devices[i]);
     lazy_tensors::Shape shape = CreateComputationShapeFromTensor(tensors[i], &device);
-    result.push_back(MakeComputationDataFromTensor(tensors[i], shape, devices[i]));
+    auto populate_fn = [&, i, device](
+                           const lazy_tensors::ComputationClient::TensorSource& source_tensor,
+                           void* dest_buffer, size_t dest_buffer_size) {
+      PopulateTensorBuffer(tensors[i], source_tensor.shape, dest_buffer, dest_buffer_size, device);
+    };
+    source_tensors.emplace_back(lazy_tensors::ToShapeData(shape), devices[i],
+                                std::move(populate_fn));
   }
-  return result;
+  auto handles = lazy_tensors::ComputationClient::Get()->TransferToServer(source_tensors);
+  LTC_CHECK_EQ(handles.size(), tensors.size());
+  return handles;
 }
 
 lazy_tensors::Literal GetTensorLiteral(const at::Tensor& tensor, const lazy_tensors::Shape* shape,
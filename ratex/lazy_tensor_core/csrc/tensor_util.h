@@ -39,6 +39,12 @@ bool TensorCompare(const at::Tensor& t1, const at::Tensor& t2);
 lazy_tensors::ComputationClient::DataPtr TensorToDataHandle(const at::Tensor& tensor,
                                                             const Device& device);
 
+// Same as TensorToDataHandle(), but the device data may share the storage of
+// the tensor when its type and layout match, so the tensor must be private to
+// the caller and not modified afterwards.
+lazy_tensors::ComputationClient::DataPtr TensorToSharedDataHandle(const at::Tensor& tensor,
+                                                                  const Device& device);
+
 void PopulateTensorBuffer(const at::Tensor& tensor, const lazy_tensors::Shape& dest_shape,
                           void* dest_buffer, size_t dest_buffer_size, const Device& device);
 
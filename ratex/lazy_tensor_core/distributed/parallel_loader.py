@@ -168,7 +168,8 @@ class ParallelLoader(object):
             batch = self._get_batch(dqueue)
             if not batch:
                 break
-            batch = ltm.send_cpu_data_to_device(batch, device)
+            with ltm.closure_priority("background"):
+                batch = ltm.send_cpu_data_to_device(batch, device)
             for data in batch:
                 dqueue.queue.put(data)
         dqueue.queue.close_write()
@@ -0,0 +1,256 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Memory-mapped checkpoints of lazy tensors.
+
+A checkpoint is a single file holding a header, the raw bytes of each tensor aligned to pages,
+and an index describing the tensors along with the pickled structure of the saved data:
+
+    | magic | version | index offset | index size | tensor blobs ... | index |
+
+On save, the lazy tensors are fetched from the device in bulk and written in parallel straight
+from the fetched host buffers. On load, the file is mapped in memory and the tensors are views
+over it, which are uploaded in bulk when a device is given, so that the file is read by the
+transfers themselves. Tensors can be loaded selectively by name, and each rank can save and load
+its own shard of a checkpoint.
+"""
+from __future__ import division
+from __future__ import print_function
+
+from concurrent import futures
+import ctypes
+import mmap
+import os
+import pickle
+import struct
+
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as ltm
+
+_MAGIC = b"RTXCKPT\0"
+_VERSION = 1
+# The magic, the version, a reserved field, the offset and the size of the index.
+_HEADER = struct.Struct("<8sIIQQ")
+_ALIGNMENT = 4096
+# Large tensors are written in chunks of this size, so that they are written in parallel too.
+_CHUNK_BYTES = 64 << 20
+_NUM_THREADS = min(8, os.cpu_count() or 1)
+
+
+class TensorReference(object):
+    def __init__(self, name):
+        self.name = name
+
+
+def shard_path(path, rank):
+    """Returns the path of the checkpoint shard of a rank."""
+    return "{}.rank{}".format(path, rank)
+
+
+def _align(offset):
+    return (offset + _ALIGNMENT - 1) // _ALIGNMENT * _ALIGNMENT
+
+
+def _join(prefix, key):
+    return "{}.{}".format(prefix, key) if prefix else str(key)
+
+
+def _flatten(data, prefix, tensors, names):
+    """Replaces the tensors nested in dicts, lists and tuples with references named after their
+    path in the data, and collects them in `tensors`. A tensor found twice (e.g., tied weights)
+    is stored once."""
+    if isinstance(data, torch.Tensor):
+        name = names.get(id(data))
+        if name is None:
+            name = prefix or "tensor"
+            if name in tensors:
+                raise ValueError("Duplicate tensor name in checkpoint: {}".format(name))
+            names[id(data)] = name
+            tensors[name] = data
+        return TensorReference(name)
+    if isinstance(data, dict):
+        result = data.copy()
+        for key, value in data.items():
+            result[key] = _flatten(value, _join(prefix, key), tensors, names)
+        return result
+    if isinstance(data, (list, tuple)):
+        items = [_flatten(v, _join(prefix, i), tensors, names) for i, v in enumerate(data)]
+        if hasattr(data, "_fields"):
+            return type(data)(*items)
+        return type(data)(items)
+    return data
+
+
+def _unflatten(data, tensors):
+    if isinstance(data, TensorReference):
+        return tensors[data.name]
+    if isinstance(data, dict):
+        result = data.copy()
+        for key, value in data.items():
+            result[key] = _unflatten(value, tensors)
+        return result
+    if isinstance(data, (list, tuple)):
+        items = [_unflatten(v, tensors) for v in data]
+        if hasattr(data, "_fields"):
+            return type(data)(*items)
+        return type(data)(items)
+    return data
+
+
+def _pwrite_all(fd, buffer, offset):
+    view = memoryview(buffer).cast("B")
+    while view:
+        written = os.pwrite(fd, view, offset)
+        view = view[written:]
+        offset += written
+
+
+def _write(path, structure, tensors):
+    index = {"tensors": {}, "data": structure}
+    chunks = []
+    offset = _align(_HEADER.size)
+    for name, tensor in tensors.items():
+        tensor = tensor.detach().contiguous()
+        nbytes = tensor.numel() * tensor.element_size()
+        index["tensors"][name] = (tensor.dtype, tuple(tensor.shape), offset, nbytes)
+        for start in range(0, nbytes, _CHUNK_BYTES):
+            size = min(_CHUNK_BYTES, nbytes - start)
+            # A view over the tensor memory, without copying it.
+            buffer = (ctypes.c_char * size).from_address(tensor.data_ptr() + start)
+            chunks.append((tensor, buffer, offset + start))
+        offset = _align(offset + nbytes)
+    index_bytes = pickle.dumps(index, protocol=pickle.HIGHEST_PROTOCOL)
+
+    # Write to a temporary file first, so that an interrupted save leaves the old checkpoint.
+    tmp_path = path + ".tmp"
+    fd = os.open(tmp_path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o644)
+    try:
+        _pwrite_all(fd, _HEADER.pack(_MAGIC, _VERSION, 0, offset, len(index_bytes)), 0)
+        with futures.ThreadPoolExecutor(max_workers=_NUM_THREADS) as executor:
+            writes = [executor.submit(_pwrite_all, fd, buffer, at) for _, buffer, at in chunks]
+            for write in writes:
+                write.result()
+        _pwrite_all(fd, index_bytes, offset)
+        os.fsync(fd)
+    finally:
+        os.close(fd)
+    os.replace(tmp_path, path)
+
+
+def save(data, path, master_only=True, global_master=False, rank=None):
+    """Saves the input data into a memory-mapped checkpoint file.
+
+    The tensors nested in dicts, lists and tuples are stored as raw blobs named after their path
+    in the data (e.g., "model.fc.weight"), which can be loaded selectively. Other objects are
+    pickled.
+
+    Args:
+      data: The input data to be saved. Any nested combination of Python objects.
+      path: The destination file for the data saving operation.
+      master_only (bool, optional): Whether only the master device should save the data.
+        Default: True
+      global_master (bool, optional): When ``master_only`` is ``True`` this flag controls
+        whether every host's master (if ``global_master`` is ``False``) saves the content, or
+        only the global master (ordinal 0).
+        Default: False
+      rank (int, optional): If set, the data is the shard of the given rank (e.g., its
+        partition of the optimizer states), which every rank saves to `shard_path(path, rank)`.
+        Default: None
+    """
+    if rank is not None:
+        path = shard_path(path, rank)
+        should_write_data = True
+    else:
+        should_write_data = not master_only or ltm.is_master_ordinal(local=not global_master)
+
+    tensors = {}
+    structure = _flatten(data, "", tensors, {})
+    # The pending computations and the device data are fetched in bulk.
+    lazy_names = [name for name, tensor in tensors.items() if ltm.is_lazy_tensor(tensor)]
+    cpu_tensors = ltm._maybe_convert_to_cpu([tensors[name] for name in lazy_names])
+    tensors.update(zip(lazy_names, cpu_tensors))
+    if should_write_data:
+        _write(path, structure, tensors)
+    if rank is None:
+        ltm.rendezvous("lazy_tensor_core.utils.mmap_checkpoint.save")
+
+
+class CheckpointReader(object):
+    """Reads a checkpoint saved with the `save()` API.
+
+    The file is mapped in memory and its tensors are copy-on-write views over it, so only the
+    pages of the tensors actually loaded are read.
+
+    Args:
+      path (str): The path of the checkpoint file.
+    """
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self._mmap = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_COPY)
+        magic, version, _, index_offset, index_size = _HEADER.unpack_from(self._mmap, 0)
+        if magic != _MAGIC:
+            raise ValueError("Not a checkpoint file: {}".format(path))
+        if version != _VERSION:
+            raise ValueError("Unsupported checkpoint version {}: {}".format(version, path))
+        index = pickle.loads(self._mmap[index_offset : index_offset + index_size])
+        self._tensors = index["tensors"]
+        self._data = index["data"]
+
+    def names(self):
+        """Returns the names of the tensors in the checkpoint."""
+        return list(self._tensors)
+
+    def tensor(self, name):
+        """Returns the CPU tensor of the given name, as a view over the file."""
+        dtype, shape, offset, nbytes = self._tensors[name]
+        if nbytes == 0:
+            return torch.empty(shape, dtype=dtype)
+        numel = nbytes // torch.empty((), dtype=dtype).element_size()
+        return torch.frombuffer(self._mmap, dtype=dtype, count=numel, offset=offset).view(shape)
+
+    def load(self, names=None, device=None):
+        """Loads the tensors of the given names (all of them by default).
+
+        Args:
+          names (list, optional): The names of the tensors to load.
+          device (optional): If set, the tensors are uploaded to this device in bulk.
+        Returns:
+          A dict from the names to the tensors.
+        """
+        names = self.names() if names is None else list(names)
+        if len(names) == len(self._tensors) and hasattr(mmap, "MADV_WILLNEED"):
+            # Let the kernel read ahead the whole file.
+            self._mmap.madvise(mmap.MADV_WILLNEED)
+        tensors = [self.tensor(name) for name in names]
+        if device is not None:
+            # Loading must not delay the executions of the steps running meanwhile.
+            with ltm.closure_priority("background"):
+                tensors = ltm.send_cpu_data_to_device(tensors, device)
+        return dict(zip(names, tensors))
+
+    def data(self, device=None):
+        """Returns the saved data, with all its tensors loaded (to `device`, if set)."""
+        return _unflatten(self._data, self.load(device=device))
+
+
+def load(path, device=None, names=None, rank=None):
+    """Loads data previously saved with the `save()` API.
+
+    Args:
+      path (str): The path passed to the `save()` API.
+      device (optional): If set, the tensors are uploaded to this device in bulk. Otherwise they
+        are CPU tensors backed by the file.
+      names (list, optional): If set, only the tensors of these names are loaded, and returned
+        as a dict from names to tensors.
+      rank (int, optional): If set, the shard of the given rank is loaded.
+    Returns:
+      The loaded data.
+    """
+    if rank is not None:
+        path = shard_path(path, rank)
+    reader = CheckpointReader(path)
+    if names is not None:
+        return reader.load(names, device)
+    return reader.data(device)
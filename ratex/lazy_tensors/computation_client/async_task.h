@@ -43,7 +43,7 @@ class AsyncTask {
   AsyncTask& Wait() {
     std::unique_lock<std::mutex> lock(data_->mutex);
     LTC_CHECK(data_->scheduled);
-    data_->cv.wait(lock, [this] { return data_->completed; });
+    env::BlockingWait(&lock, &data_->cv, [this] { return data_->completed; });
     if (data_->exptr != nullptr) {
       std::rethrow_exception(data_->exptr);
     }
@@ -26,12 +26,19 @@ class Cache {
  public:
   using TypePtr = std::shared_ptr<T>;
   using Element = std::pair<K, TypePtr>;
+  // Returns the size of an element, in the unit of the cache limit.
+  using SizeFn = std::function<size_t(const K&, const T&)>;
 
   explicit Cache(size_t max_size) : max_size_(max_size) {
   }
 
+  // The limit is on the total size of the elements as measured by size_fn
+  // (e.g., their bytes) instead of their count.
+  Cache(size_t max_size, SizeFn size_fn) : max_size_(max_size), size_fn_(std::move(size_fn)) {
+  }
+
   // Adds an object to the cache, unless it already exists. If the cache grows
-  // beyond the limit set during construction, the oldest used object will be
+  // beyond the limit set during construction, the oldest used objects will be
   // removed from the cache.
   TypePtr Add(K key, TypePtr object) {
     std::lock_guard<std::mutex> slock(lock_);
@@ -41,12 +48,17 @@ class Cache {
     if (!emplace_result.second) {
       element_list_.erase(it);
       DoLRU(emplace_result.first->second);
-    } else if (element_list_.size() > max_size_) {
+      return emplace_result.first->second->second;
+    }
+    TypePtr result = it->second;
+    total_size_ += ElementSize(*it);
+    while (total_size_ > max_size_ && !element_list_.empty()) {
       Element* last = &element_list_.back();
+      total_size_ -= ElementSize(*last);
       element_map_.erase(&last->first);
       element_list_.pop_back();
     }
-    return emplace_result.first->second->second;
+    return result;
   }
 
   // Retrieves the existing object if it exists. If it does, it's position in
@@ -70,6 +82,7 @@ class Cache {
       return false;
     }
     auto lit = it->second;
+    total_size_ -= ElementSize(*lit);
     element_map_.erase(it);
     element_list_.erase(lit);
     return true;
@@ -79,6 +92,7 @@ class Cache {
     std::lock_guard<std::mutex> slock(lock_);
     element_map_.clear();
     element_list_.clear();
+    total_size_ = 0;
   }
 
  private:
@@ -106,8 +120,14 @@ class Cache {
     element_list_.splice(element_list_.begin(), element_list_, it);
   }
 
+  size_t ElementSize(const Element& element) const {
+    return size_fn_ != nullptr ? size_fn_(element.first, *element.second) : 1;
+  }
+
   std::mutex lock_;
   size_t max_size_ = 0;
+  SizeFn size_fn_;
+  size_t total_size_ = 0;
   ElementList element_list_;
   ElementMap element_map_;
 };
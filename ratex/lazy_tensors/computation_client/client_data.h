@@ -10,9 +10,12 @@
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "lazy_tensors/computation_client/future.h"
+
 namespace lazy_tensors {
 
 enum class PrimitiveType {
@@ -119,10 +122,26 @@ class Data {
 
   virtual bool HasValue() const = 0;
 
+  // The readiness event of the data, ready once the execution producing its
+  // value completes (or failed, if it failed). Readers wait on the events of
+  // the data they need instead of on the whole device. An invalid future means
+  // that the data has no pending producer.
+  util::Future<void> ready() const {
+    std::lock_guard<std::mutex> lock(ready_mutex_);
+    return ready_;
+  }
+
+  void SetReady(util::Future<void> ready) {
+    std::lock_guard<std::mutex> lock(ready_mutex_);
+    ready_ = std::move(ready);
+  }
+
  private:
   std::string device_;
   ShapeData shape_;
   std::shared_ptr<Info> info_;
+  mutable std::mutex ready_mutex_;
+  util::Future<void> ready_;
 };
 
 using DataPtr = std::shared_ptr<Data>;
@@ -143,6 +162,12 @@ struct TensorSource {
   ShapeData shape;
   std::string device;
   PopulateFn populate_fn;
+  // The host data of the tensor in the type and standard array layout of the
+  // shape, if available. A client may use it as the device buffer instead of
+  // calling populate_fn, keeping data_owner alive as long as the device data,
+  // so the data must not be modified elsewhere afterwards.
+  const void* data = nullptr;
+  std::shared_ptr<void> data_owner;
 };
 
 }  // namespace client
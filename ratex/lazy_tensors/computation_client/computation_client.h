@@ -17,6 +17,7 @@
 
 #include "absl/types/optional.h"
 #include "lazy_tensors/computation_client/client_data.h"
+#include "lazy_tensors/computation_client/future.h"
 #include "lazy_tensors/computation_client/metrics.h"
 #include "lazy_tensors/computation_client/types.h"
 #include "lazy_tensors/literal_util.h"
@@ -126,6 +127,7 @@ class ComputationClient {
   struct MemoryInfo {
     int64_t kb_free = 0;
     int64_t kb_total = 0;
+    int64_t kb_peak = 0;
   };
 
   static std::unique_ptr<ComputationClient> Create();
@@ -195,6 +197,43 @@ class ComputationClient {
   virtual std::vector<std::vector<DataPtr>> DeconstructTuple(
       lazy_tensors::Span<const DataPtr> tuples) = 0;
 
+  // Non-blocking variants of the APIs above, which return futures instead of
+  // blocking the calling thread, so that pipelines (e.g., execute, then fetch
+  // the results, then a callback) chain continuations instead of parking pool
+  // threads. The default implementations run the blocking APIs on the IO thread
+  // pool, with the priority of the calling thread.
+  virtual util::Future<std::vector<DataPtr>> TransferToServerAsync(
+      std::vector<TensorSource> tensors) {
+    return util::RunAsync(
+        [this, tensors = std::move(tensors)]() { return TransferToServer(tensors); },
+        util::Executor::kIo);
+  }
+
+  virtual util::Future<std::vector<Literal>> TransferFromServerAsync(
+      std::vector<DataPtr> handles) {
+    return util::RunAsync(
+        [this, handles = std::move(handles)]() { return TransferFromServer(handles); },
+        util::Executor::kIo);
+  }
+
+  virtual util::Future<std::vector<ComputationPtr>> CompileAsync(
+      std::vector<CompileInstance> instances) {
+    return util::RunAsync(
+        [this, instances = std::move(instances)]() { return Compile(instances); },
+        util::Executor::kIo);
+  }
+
+  virtual util::Future<std::vector<DataPtr>> ExecuteComputationAsync(
+      ComputationPtr computation, std::vector<DataPtr> arguments, std::string device,
+      ExecuteComputationOptions options) {
+    return util::RunAsync(
+        [this, computation = std::move(computation), arguments = std::move(arguments),
+         device = std::move(device), options]() {
+          return ExecuteComputation(*computation, arguments, device, options);
+        },
+        util::Executor::kIo);
+  }
+
   // Returns a unique string which identifies the resource domain of a given
   // device. Within a resource domain, handles to device memory or compiled
   // computations can be used for all devices part of such domain.
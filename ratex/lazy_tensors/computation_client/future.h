@@ -0,0 +1,375 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef COMPUTATION_CLIENT_FUTURE_H_
+#define COMPUTATION_CLIENT_FUTURE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/types/optional.h"
+#include "lazy_tensors/computation_client/debug_macros.h"
+#include "lazy_tensors/computation_client/thread_pool.h"
+
+namespace lazy_tensors {
+namespace util {
+
+// Where the continuations of a future run.
+enum class Executor {
+  // On the thread completing the future, or on the thread adding the
+  // continuation if the future is already complete. For short continuations
+  // which do not block.
+  kInline,
+  // On the compute thread pool.
+  kCompute,
+  // On the IO thread pool, for continuations which may block.
+  kIo,
+};
+
+inline void RunOnExecutor(Executor executor, env::Priority priority, std::function<void()> fn) {
+  switch (executor) {
+    case Executor::kInline:
+      fn();
+      break;
+    case Executor::kCompute:
+      env::ScheduleClosure(std::move(fn), priority);
+      break;
+    case Executor::kIo:
+      env::ScheduleIoClosure(std::move(fn), priority);
+      break;
+  }
+}
+
+template <typename T>
+class Future;
+
+template <typename T>
+class Promise;
+
+namespace internal {
+
+struct Empty {};
+
+// The type holding the value of a Future<T>.
+template <typename T>
+using StoredType = typename std::conditional<std::is_void<T>::value, Empty, T>::type;
+
+// ValueType is the type of the value of a future, or the type itself otherwise.
+template <typename T>
+struct IsFuture : std::false_type {
+  using ValueType = T;
+};
+
+template <typename T>
+struct IsFuture<Future<T>> : std::true_type {
+  using ValueType = T;
+};
+
+template <typename T, typename F, typename = void>
+struct InvokeResult {
+  using type = decltype(std::declval<F&>()(std::declval<const T&>()));
+};
+
+template <typename T, typename F>
+struct InvokeResult<T, F, typename std::enable_if<std::is_void<T>::value>::type> {
+  using type = decltype(std::declval<F&>()());
+};
+
+// The value type of the future returned by Future<T>::Then(fn). A continuation
+// returning a future is flattened into the returned future.
+template <typename T, typename F>
+struct ContinuationResult {
+  using Raw = typename InvokeResult<T, F>::type;
+  using type = typename IsFuture<Raw>::ValueType;
+};
+
+template <typename T>
+class FutureState {
+ public:
+  void SetValue(StoredType<T> value) {
+    Complete(std::move(value), nullptr);
+  }
+
+  void SetException(std::exception_ptr exptr) {
+    Complete(absl::nullopt, std::move(exptr));
+  }
+
+  // Runs the callback once the state is complete, inline.
+  void OnReady(std::function<void()> callback) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!completed_) {
+        callbacks_.push_back(std::move(callback));
+        return;
+      }
+    }
+    callback();
+  }
+
+  bool IsReady() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completed_;
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    env::BlockingWait(&lock, &cv_, [this] { return completed_; });
+  }
+
+  // The value and the exception are immutable once the state is complete.
+  const StoredType<T>& value() const {
+    return *value_;
+  }
+
+  const std::exception_ptr& exception() const {
+    return exptr_;
+  }
+
+ private:
+  void Complete(absl::optional<StoredType<T>> value, std::exception_ptr exptr) {
+    std::vector<std::function<void()>> callbacks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      LTC_CHECK(!completed_) << "Future already completed";
+      value_ = std::move(value);
+      exptr_ = std::move(exptr);
+      completed_ = true;
+      callbacks.swap(callbacks_);
+    }
+    cv_.notify_all();
+    for (auto& callback : callbacks) {
+      callback();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool completed_ = false;
+  absl::optional<StoredType<T>> value_;
+  std::exception_ptr exptr_;
+  std::vector<std::function<void()>> callbacks_;
+};
+
+}  // namespace internal
+
+// The producer side of a Future. Copies of a promise share the same state,
+// which must be completed exactly once.
+template <typename T>
+class Promise {
+ public:
+  Promise() : state_(std::make_shared<internal::FutureState<T>>()) {
+  }
+
+  Future<T> GetFuture() const {
+    return Future<T>(state_);
+  }
+
+  // For a Promise<void>, SetValue() takes no argument.
+  void SetValue(internal::StoredType<T> value = internal::StoredType<T>()) const {
+    state_->SetValue(std::move(value));
+  }
+
+  void SetException(std::exception_ptr exptr) const {
+    state_->SetException(std::move(exptr));
+  }
+
+  // Completes the promise with the result of fn(), or with its exception.
+  template <typename F>
+  void SetWith(F&& fn) const {
+    std::exception_ptr exptr;
+    absl::optional<internal::StoredType<T>> value;
+    try {
+      if constexpr (std::is_void<T>::value) {
+        fn();
+        value = internal::Empty();
+      } else {
+        value = fn();
+      }
+    } catch (...) {
+      exptr = std::current_exception();
+    }
+    if (exptr != nullptr) {
+      SetException(std::move(exptr));
+    } else {
+      SetValue(std::move(*value));
+    }
+  }
+
+ private:
+  std::shared_ptr<internal::FutureState<T>> state_;
+};
+
+// A copyable handle to a value computed asynchronously. Instead of blocking a
+// thread in Wait(), consumers can chain continuations with Then(), which run
+// once the value is ready on the selected executor.
+template <typename T>
+class Future {
+ public:
+  Future() = default;
+
+  bool valid() const {
+    return state_ != nullptr;
+  }
+
+  bool IsReady() const {
+    return state_->IsReady();
+  }
+
+  // Waits for the future, and rethrows its exception if it failed. A pool
+  // thread runs the queued closures while waiting.
+  void Wait() const {
+    state_->Wait();
+    if (state_->exception() != nullptr) {
+      std::rethrow_exception(state_->exception());
+    }
+  }
+
+  // Waits for the future and returns its value. For a Future<void>, use Wait().
+  const internal::StoredType<T>& Get() const {
+    Wait();
+    return state_->value();
+  }
+
+  // Runs the callback once the future is ready (completed or failed), on the
+  // thread completing it, or right away if it is already ready.
+  void OnReady(std::function<void()> callback) const {
+    state_->OnReady(std::move(callback));
+  }
+
+  // Returns a future of the result of fn(value) (or fn() for a Future<void>),
+  // which runs on the executor once this future is ready. If this future fails,
+  // fn is not run and the returned future fails with the same exception. If fn
+  // returns a future, the returned future completes with it.
+  template <typename F>
+  Future<typename internal::ContinuationResult<T, F>::type> Then(
+      F fn, Executor executor = Executor::kInline,
+      env::Priority priority = env::GetThreadPriority()) const {
+    using Raw = typename internal::ContinuationResult<T, F>::Raw;
+    using R = typename internal::ContinuationResult<T, F>::type;
+    Promise<R> promise;
+    auto state = state_;
+    auto run = [state, promise, fn = std::move(fn)]() mutable {
+      auto invoke = [&]() -> Raw {
+        if constexpr (std::is_void<T>::value) {
+          return fn();
+        } else {
+          return fn(state->value());
+        }
+      };
+      if constexpr (internal::IsFuture<Raw>::value) {
+        Raw inner;
+        try {
+          inner = invoke();
+        } catch (...) {
+          promise.SetException(std::current_exception());
+          return;
+        }
+        inner.Forward(promise);
+      } else {
+        promise.SetWith(invoke);
+      }
+    };
+    state_->OnReady([state, promise, run = std::move(run), executor, priority]() mutable {
+      if (state->exception() != nullptr) {
+        promise.SetException(state->exception());
+      } else {
+        RunOnExecutor(executor, priority, std::move(run));
+      }
+    });
+    return promise.GetFuture();
+  }
+
+ private:
+  friend class Promise<T>;
+  template <typename U>
+  friend class Future;
+
+  explicit Future(std::shared_ptr<internal::FutureState<T>> state) : state_(std::move(state)) {
+  }
+
+  // Completes the promise with the outcome of this future.
+  void Forward(Promise<T> promise) const {
+    auto state = state_;
+    state_->OnReady([state, promise]() {
+      if (state->exception() != nullptr) {
+        promise.SetException(state->exception());
+      } else {
+        promise.SetValue(state->value());
+      }
+    });
+  }
+
+  std::shared_ptr<internal::FutureState<T>> state_;
+};
+
+inline Future<void> MakeReadyFuture() {
+  Promise<void> promise;
+  promise.SetValue();
+  return promise.GetFuture();
+}
+
+template <typename T>
+Future<typename std::decay<T>::type> MakeReadyFuture(T&& value) {
+  Promise<typename std::decay<T>::type> promise;
+  promise.SetValue(std::forward<T>(value));
+  return promise.GetFuture();
+}
+
+// Runs fn() on the executor, and returns the future of its result.
+template <typename F>
+Future<typename internal::ContinuationResult<void, F>::type> RunAsync(
+    F fn, Executor executor, env::Priority priority = env::GetThreadPriority()) {
+  return MakeReadyFuture().Then(std::move(fn), executor, priority);
+}
+
+// Returns a future ready once all the futures are. Its value is the vector of
+// their values in order (nothing for futures of void). If any of them fails,
+// it fails with the exception of the first failed one in order.
+template <typename T>
+Future<typename std::conditional<std::is_void<T>::value, void, std::vector<T>>::type> WhenAll(
+    std::vector<Future<T>> futures) {
+  using R = typename std::conditional<std::is_void<T>::value, void, std::vector<T>>::type;
+  Promise<R> promise;
+  if (futures.empty()) {
+    promise.SetValue();
+    return promise.GetFuture();
+  }
+  auto pending = std::make_shared<std::atomic<size_t>>(futures.size());
+  auto inputs = std::make_shared<std::vector<Future<T>>>(std::move(futures));
+  for (const auto& future : *inputs) {
+    future.OnReady([pending, inputs, promise]() {
+      if (pending->fetch_sub(1) > 1) {
+        return;
+      }
+      promise.SetWith([&inputs]() -> R {
+        if constexpr (std::is_void<T>::value) {
+          for (const auto& input : *inputs) {
+            input.Wait();
+          }
+        } else {
+          std::vector<T> values;
+          values.reserve(inputs->size());
+          for (const auto& input : *inputs) {
+            values.push_back(input.Get());
+          }
+          return values;
+        }
+      });
+    });
+  }
+  return promise.GetFuture();
+}
+
+}  // namespace util
+}  // namespace lazy_tensors
+
+#endif  // COMPUTATION_CLIENT_FUTURE_H_
@@ -10,6 +10,8 @@
 #include <chrono>
 #include <exception>
 
+#include "lazy_tensors/computation_client/thread_pool.h"
+
 namespace lazy_tensors {
 namespace util {
 
@@ -27,7 +29,7 @@ void MultiWait::Done() {
 
 void MultiWait::Wait() {
   std::unique_lock<std::mutex> lock(mutex_);
-  cv_.wait(lock, [this] { return completed_count_ >= count_; });
+  env::BlockingWait(&lock, &cv_, [this] { return completed_count_ >= count_; });
   if (exptr_ != nullptr) {
     std::rethrow_exception(exptr_);
   }
@@ -35,6 +37,7 @@ void MultiWait::Wait() {
 
 void MultiWait::Wait(double wait_seconds) {
   std::unique_lock<std::mutex> lock(mutex_);
+  env::BlockingRegion region;
   if (!cv_.wait_for(lock, std::chrono::duration<double>(wait_seconds),
                     [this] { return completed_count_ >= count_; })) {
     throw std::runtime_error("Timeout");
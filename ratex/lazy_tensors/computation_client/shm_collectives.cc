@@ -0,0 +1,524 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "lazy_tensors/computation_client/shm_collectives.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <complex>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+#include "lazy_tensors/computation_client/debug_macros.h"
+#include "lazy_tensors/computation_client/metrics.h"
+#include "lazy_tensors/computation_client/sys_util.h"
+#include "lazy_tensors/types.h"
+
+namespace lazy_tensors {
+
+struct ShmCommunicator::Header {
+  // Set by rank 0 once the header is initialized.
+  std::atomic<uint64_t> magic;
+  // The process ID of rank 0, which tells a live segment from one left by a
+  // crashed run of the same name.
+  pid_t creator;
+  int64_t size;
+  int64_t slot_bytes;
+  std::atomic<int64_t> attached;
+  // The number of ranks arrived at the current barrier, and the futex word
+  // bumped by the last one to release the others.
+  std::atomic<uint32_t> arrived;
+  std::atomic<uint32_t> generation;
+};
+
+namespace {
+
+constexpr uint64_t kMagic = 0x5241544558534d32;  // "RATEXSM2"
+// The slots start on their own page.
+constexpr int64_t kHeaderBytes = 4096;
+constexpr int64_t kRingDepth = 2;
+// The peers usually arrive at a barrier within microseconds, so waiting spins
+// for a while before sleeping on the futex.
+constexpr int kSpinIterations = 4096;
+
+long Futex(std::atomic<uint32_t>* word, int op, uint32_t value, const struct timespec* timeout) {
+  // The futex word is shared across processes, so the private flavors of the
+  // operations cannot be used.
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+template <typename T>
+struct AccumulateType {
+  using type = T;
+};
+
+template <>
+struct AccumulateType<c10::Half> {
+  using type = float;
+};
+
+template <>
+struct AccumulateType<c10::BFloat16> {
+  using type = float;
+};
+
+template <typename T>
+struct IsComplex : std::false_type {};
+
+template <typename T>
+struct IsComplex<std::complex<T>> : std::true_type {};
+
+template <typename T, typename F>
+void Accumulate(T* acc, const T* input, int64_t count, const F& fn) {
+  for (int64_t i = 0; i < count; ++i) {
+    acc[i] = fn(acc[i], input[i]);
+  }
+}
+
+// Computes acc[i] = op(acc[i], input[i]). The 16 bits floating point types are
+// combined in single precision.
+template <typename T>
+void Accumulate(T* acc, const T* input, int64_t count, ShmCommunicator::ReduceOp op) {
+  using A = typename AccumulateType<T>::type;
+  switch (op) {
+    case ShmCommunicator::ReduceOp::kSum:
+      Accumulate(acc, input, count, [](T a, T b) {
+        return static_cast<T>(static_cast<A>(a) + static_cast<A>(b));
+      });
+      return;
+    case ShmCommunicator::ReduceOp::kProd:
+      Accumulate(acc, input, count, [](T a, T b) {
+        return static_cast<T>(static_cast<A>(a) * static_cast<A>(b));
+      });
+      return;
+    case ShmCommunicator::ReduceOp::kMin:
+      if constexpr (!IsComplex<T>::value) {
+        Accumulate(acc, input, count,
+                   [](T a, T b) { return static_cast<A>(b) < static_cast<A>(a) ? b : a; });
+        return;
+      }
+      break;
+    case ShmCommunicator::ReduceOp::kMax:
+      if constexpr (!IsComplex<T>::value) {
+        Accumulate(acc, input, count,
+                   [](T a, T b) { return static_cast<A>(a) < static_cast<A>(b) ? b : a; });
+        return;
+      }
+      break;
+    case ShmCommunicator::ReduceOp::kAnd:
+      if constexpr (std::is_integral<T>::value) {
+        Accumulate(acc, input, count, [](T a, T b) { return static_cast<T>(a & b); });
+        return;
+      }
+      break;
+    case ShmCommunicator::ReduceOp::kOr:
+      if constexpr (std::is_integral<T>::value) {
+        Accumulate(acc, input, count, [](T a, T b) { return static_cast<T>(a | b); });
+        return;
+      }
+      break;
+  }
+  LTC_LOG(FATAL) << "Unsupported reduction " << static_cast<int>(op)
+                 << " for the element type of " << sizeof(T) << " bytes";
+}
+
+// The predicates are bytes holding 0 or 1, which are reduced as booleans.
+ShmCommunicator::ReduceOp PredicateReduceOp(ShmCommunicator::ReduceOp op) {
+  switch (op) {
+    case ShmCommunicator::ReduceOp::kSum:
+    case ShmCommunicator::ReduceOp::kMax:
+    case ShmCommunicator::ReduceOp::kOr:
+      return ShmCommunicator::ReduceOp::kOr;
+    default:
+      return ShmCommunicator::ReduceOp::kAnd;
+  }
+}
+
+// Calls fn with a null pointer of the C++ type of the element type.
+template <typename F>
+void DispatchType(PrimitiveType type, const F& fn) {
+  switch (type) {
+    case PrimitiveType::PRED:
+    case PrimitiveType::U8:
+      return fn(static_cast<uint8_t*>(nullptr));
+    case PrimitiveType::S8:
+      return fn(static_cast<int8_t*>(nullptr));
+    case PrimitiveType::S16:
+      return fn(static_cast<int16_t*>(nullptr));
+    case PrimitiveType::S32:
+      return fn(static_cast<int32_t*>(nullptr));
+    case PrimitiveType::S64:
+      return fn(static_cast<int64_t*>(nullptr));
+    case PrimitiveType::U16:
+      return fn(static_cast<uint16_t*>(nullptr));
+    case PrimitiveType::U32:
+      return fn(static_cast<uint32_t*>(nullptr));
+    case PrimitiveType::U64:
+      return fn(static_cast<uint64_t*>(nullptr));
+    case PrimitiveType::F16:
+      return fn(static_cast<c10::Half*>(nullptr));
+    case PrimitiveType::BF16:
+      return fn(static_cast<c10::BFloat16*>(nullptr));
+    case PrimitiveType::F32:
+      return fn(static_cast<float*>(nullptr));
+    case PrimitiveType::F64:
+      return fn(static_cast<double*>(nullptr));
+    case PrimitiveType::C64:
+      return fn(static_cast<std::complex<float>*>(nullptr));
+    case PrimitiveType::C128:
+      return fn(static_cast<std::complex<double>*>(nullptr));
+    default:
+      LTC_LOG(FATAL) << "Unsupported element type for shared memory collectives: " << type;
+  }
+}
+
+template <typename T>
+using ElementType = typename std::remove_pointer<T>::type;
+
+bool IsProcessAlive(pid_t pid) {
+  return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+}  // namespace
+
+ShmCommunicator::ShmCommunicator(std::string name, int64_t rank, int64_t size, int64_t slot_bytes,
+                                 double timeout_s)
+    : name_(std::move(name)),
+      rank_(rank),
+      size_(size),
+      // Each buffer of the ring is cache line aligned.
+      slot_bytes_(slot_bytes / (kRingDepth * 64) * (kRingDepth * 64)),
+      timeout_ns_(static_cast<int64_t>(timeout_s * 1e9)) {
+  LTC_CHECK_GT(size_, 0);
+  LTC_CHECK(rank_ >= 0 && rank_ < size_) << "Invalid rank " << rank_ << " of " << size_;
+  // A segmented chunk holds at least one 16 bytes element per rank.
+  LTC_CHECK_GE(slot_bytes_ / kRingDepth, size_ * 16)
+      << "The shared memory slot of " << slot_bytes << " bytes is too small for " << size_
+      << " ranks";
+  mapped_bytes_ = kHeaderBytes + size_ * slot_bytes_;
+  Attach();
+}
+
+ShmCommunicator::~ShmCommunicator() {
+  if (base_ != nullptr) {
+    munmap(base_, mapped_bytes_);
+  }
+}
+
+ShmCommunicator::ReduceOp ShmCommunicator::ParseReduceOp(const std::string& name) {
+  if (name == "sum") {
+    return ReduceOp::kSum;
+  }
+  if (name == "mul" || name == "prod") {
+    return ReduceOp::kProd;
+  }
+  if (name == "min") {
+    return ReduceOp::kMin;
+  }
+  if (name == "max") {
+    return ReduceOp::kMax;
+  }
+  if (name == "and") {
+    return ReduceOp::kAnd;
+  }
+  if (name == "or") {
+    return ReduceOp::kOr;
+  }
+  LTC_LOG(FATAL) << "Invalid reduce type: " << name;
+}
+
+void ShmCommunicator::Attach() {
+  int64_t deadline = sys_util::NowNs() + timeout_ns_;
+  if (rank_ == 0) {
+    // Remove the segment left by a crashed run of the same name, if any.
+    shm_unlink(name_.c_str());
+    int fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    LTC_CHECK_GE(fd, 0) << "Failed to create the shared memory segment " << name_ << ": "
+                        << std::strerror(errno);
+    LTC_CHECK_EQ(ftruncate(fd, mapped_bytes_), 0)
+        << "Failed to size the shared memory segment " << name_ << ": " << std::strerror(errno);
+    void* base = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    LTC_CHECK(base != MAP_FAILED) << "Failed to map the shared memory segment " << name_ << ": "
+                                  << std::strerror(errno);
+    base_ = static_cast<char*>(base);
+    header_ = new (base_) Header();
+    header_->creator = getpid();
+    header_->size = size_;
+    header_->slot_bytes = slot_bytes_;
+    header_->attached.store(0);
+    header_->arrived.store(0);
+    header_->generation.store(0);
+    header_->magic.store(kMagic, std::memory_order_release);
+  } else {
+    // Wait for rank 0 to create and initialize the segment. A segment whose
+    // creator exited is left by a crashed run, which rank 0 is about to
+    // replace, so attaching to it would wait for peers which never come.
+    while (true) {
+      int fd = shm_open(name_.c_str(), O_RDWR, 0600);
+      if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(mapped_bytes_)) {
+          void* base = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+          LTC_CHECK(base != MAP_FAILED) << "Failed to map the shared memory segment " << name_
+                                        << ": " << std::strerror(errno);
+          Header* header = static_cast<Header*>(base);
+          if (header->magic.load(std::memory_order_acquire) == kMagic &&
+              IsProcessAlive(header->creator) && header->attached.load() < size_) {
+            close(fd);
+            base_ = static_cast<char*>(base);
+            header_ = header;
+            break;
+          }
+          munmap(base, mapped_bytes_);
+        }
+        close(fd);
+      }
+      LTC_CHECK_LT(sys_util::NowNs(), deadline)
+          << "Timed out waiting for rank 0 to create the shared memory segment " << name_;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    LTC_CHECK_EQ(header_->size, size_) << "Mismatching size of the communicator " << name_;
+    LTC_CHECK_EQ(header_->slot_bytes, slot_bytes_)
+        << "Mismatching slot size of the communicator " << name_;
+  }
+  header_->attached.fetch_add(1);
+  Barrier();
+  if (rank_ == 0) {
+    // All the ranks hold a mapping, so the name is no longer needed, and the
+    // memory is released when the last of them exits.
+    shm_unlink(name_.c_str());
+  }
+}
+
+void ShmCommunicator::Barrier() {
+  uint32_t generation = header_->generation.load(std::memory_order_acquire);
+  if (header_->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == size_) {
+    header_->arrived.store(0, std::memory_order_relaxed);
+    header_->generation.fetch_add(1, std::memory_order_release);
+    Futex(&header_->generation, FUTEX_WAKE, INT_MAX, nullptr);
+    return;
+  }
+  for (int i = 0; i < kSpinIterations; ++i) {
+    if (header_->generation.load(std::memory_order_acquire) != generation) {
+      return;
+    }
+    CpuRelax();
+  }
+  static metrics::Counter* futex_waits = new metrics::Counter("ShmBarrierFutexWaits");
+  futex_waits->AddValue(1);
+  int64_t deadline = sys_util::NowNs() + timeout_ns_;
+  while (header_->generation.load(std::memory_order_acquire) == generation) {
+    struct timespec timeout = {1, 0};
+    Futex(&header_->generation, FUTEX_WAIT, generation, &timeout);
+    LTC_CHECK_LT(sys_util::NowNs(), deadline)
+        << "Timed out waiting for the peers of the shared memory communicator " << name_;
+  }
+}
+
+char* ShmCommunicator::Buffer(int64_t rank) const {
+  return base_ + kHeaderBytes + rank * slot_bytes_ + ring_index_ * (slot_bytes_ / kRingDepth);
+}
+
+int64_t ShmCommunicator::ChunkElements(int64_t element_bytes, bool segmented) const {
+  int64_t buffer_bytes = slot_bytes_ / kRingDepth;
+  return (segmented ? buffer_bytes / size_ : buffer_bytes) / element_bytes;
+}
+
+void ShmCommunicator::AllReduce(void* data, int64_t count, PrimitiveType type, ReduceOp op) {
+  if (type == PrimitiveType::PRED) {
+    op = PredicateReduceOp(op);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  LTC_TIMED("ShmAllReduce");
+  DispatchType(type, [&](auto* tag) {
+    using T = ElementType<decltype(tag)>;
+    LTC_COUNTER("ShmCollectiveBytes", count * sizeof(T));
+    T* values = static_cast<T*>(data);
+    int64_t chunk = ChunkElements(sizeof(T), /*segmented=*/false);
+    for (int64_t offset = 0; offset < count; offset += chunk) {
+      int64_t n = std::min(chunk, count - offset);
+      // Each rank reduces one part of the chunk into its own buffer, where the
+      // others read it. The parts are disjoint, so no rank writes what another
+      // one reads between two barriers.
+      int64_t part = (n + size_ - 1) / size_;
+      auto part_begin = [&](int64_t rank) { return std::min(rank * part, n); };
+      auto part_end = [&](int64_t rank) { return std::min((rank + 1) * part, n); };
+      T* own = reinterpret_cast<T*>(Buffer(rank_));
+      std::memcpy(own, values + offset, n * sizeof(T));
+      Barrier();
+      int64_t begin = part_begin(rank_);
+      int64_t end = part_end(rank_);
+      for (int64_t peer = 0; peer < size_; ++peer) {
+        if (peer != rank_) {
+          Accumulate(own + begin, reinterpret_cast<const T*>(Buffer(peer)) + begin, end - begin,
+                     op);
+        }
+      }
+      Barrier();
+      for (int64_t peer = 0; peer < size_; ++peer) {
+        begin = part_begin(peer);
+        std::memcpy(values + offset + begin, reinterpret_cast<const T*>(Buffer(peer)) + begin,
+                    (part_end(peer) - begin) * sizeof(T));
+      }
+      NextBuffer();
+    }
+  });
+}
+
+void ShmCommunicator::AllGather(const void* input, void* output, int64_t count,
+                                PrimitiveType type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LTC_TIMED("ShmAllGather");
+  DispatchType(type, [&](auto* tag) {
+    using T = ElementType<decltype(tag)>;
+    LTC_COUNTER("ShmCollectiveBytes", count * sizeof(T));
+    const T* values = static_cast<const T*>(input);
+    T* results = static_cast<T*>(output);
+    int64_t chunk = ChunkElements(sizeof(T), /*segmented=*/false);
+    for (int64_t offset = 0; offset < count; offset += chunk) {
+      int64_t n = std::min(chunk, count - offset);
+      std::memcpy(Buffer(rank_), values + offset, n * sizeof(T));
+      Barrier();
+      for (int64_t peer = 0; peer < size_; ++peer) {
+        std::memcpy(results + peer * count + offset, Buffer(peer), n * sizeof(T));
+      }
+      NextBuffer();
+    }
+  });
+}
+
+void ShmCommunicator::ReduceScatter(const void* input, void* output, int64_t count,
+                                    PrimitiveType type, ReduceOp op) {
+  if (type == PrimitiveType::PRED) {
+    op = PredicateReduceOp(op);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  LTC_TIMED("ShmReduceScatter");
+  DispatchType(type, [&](auto* tag) {
+    using T = ElementType<decltype(tag)>;
+    LTC_COUNTER("ShmCollectiveBytes", size_ * count * sizeof(T));
+    const T* values = static_cast<const T*>(input);
+    T* results = static_cast<T*>(output);
+    int64_t chunk = ChunkElements(sizeof(T), /*segmented=*/true);
+    for (int64_t offset = 0; offset < count; offset += chunk) {
+      int64_t n = std::min(chunk, count - offset);
+      // The i-th segment of a buffer stages the chunk of the i-th block.
+      T* own = reinterpret_cast<T*>(Buffer(rank_));
+      for (int64_t block = 0; block < size_; ++block) {
+        std::memcpy(own + block * chunk, values + block * count + offset, n * sizeof(T));
+      }
+      Barrier();
+      T* result = results + offset;
+      std::memcpy(result, reinterpret_cast<const T*>(Buffer(0)) + rank_ * chunk, n * sizeof(T));
+      for (int64_t peer = 1; peer < size_; ++peer) {
+        Accumulate(result, reinterpret_cast<const T*>(Buffer(peer)) + rank_ * chunk, n, op);
+      }
+      NextBuffer();
+    }
+  });
+}
+
+void ShmCommunicator::Broadcast(void* data, int64_t count, PrimitiveType type, int64_t root) {
+  LTC_CHECK(root >= 0 && root < size_) << "Invalid root rank " << root << " of " << size_;
+  std::lock_guard<std::mutex> lock(mutex_);
+  LTC_TIMED("ShmBroadcast");
+  DispatchType(type, [&](auto* tag) {
+    using T = ElementType<decltype(tag)>;
+    LTC_COUNTER("ShmCollectiveBytes", count * sizeof(T));
+    T* values = static_cast<T*>(data);
+    int64_t chunk = ChunkElements(sizeof(T), /*segmented=*/false);
+    for (int64_t offset = 0; offset < count; offset += chunk) {
+      int64_t n = std::min(chunk, count - offset);
+      if (rank_ == root) {
+        std::memcpy(Buffer(root), values + offset, n * sizeof(T));
+      }
+      Barrier();
+      if (rank_ != root) {
+        std::memcpy(values + offset, Buffer(root), n * sizeof(T));
+      }
+      NextBuffer();
+    }
+  });
+}
+
+void ShmCommunicator::AllToAll(const void* input, void* output, int64_t count,
+                               PrimitiveType type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  LTC_TIMED("ShmAllToAll");
+  DispatchType(type, [&](auto* tag) {
+    using T = ElementType<decltype(tag)>;
+    LTC_COUNTER("ShmCollectiveBytes", size_ * count * sizeof(T));
+    const T* values = static_cast<const T*>(input);
+    T* results = static_cast<T*>(output);
+    int64_t chunk = ChunkElements(sizeof(T), /*segmented=*/true);
+    for (int64_t offset = 0; offset < count; offset += chunk) {
+      int64_t n = std::min(chunk, count - offset);
+      T* own = reinterpret_cast<T*>(Buffer(rank_));
+      for (int64_t block = 0; block < size_; ++block) {
+        std::memcpy(own + block * chunk, values + block * count + offset, n * sizeof(T));
+      }
+      Barrier();
+      for (int64_t peer = 0; peer < size_; ++peer) {
+        std::memcpy(results + peer * count + offset,
+                    reinterpret_cast<const T*>(Buffer(peer)) + rank_ * chunk, n * sizeof(T));
+      }
+      NextBuffer();
+    }
+  });
+}
+
+void ShmCommunicator::Permute(const void* input, void* output, int64_t count, PrimitiveType type,
+                              int64_t source, int64_t target) {
+  LTC_CHECK_LT(source, size_);
+  LTC_CHECK_LT(target, size_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  LTC_TIMED("ShmPermute");
+  DispatchType(type, [&](auto* tag) {
+    using T = ElementType<decltype(tag)>;
+    LTC_COUNTER("ShmCollectiveBytes", count * sizeof(T));
+    const T* values = static_cast<const T*>(input);
+    T* results = static_cast<T*>(output);
+    int64_t chunk = ChunkElements(sizeof(T), /*segmented=*/false);
+    if (source < 0) {
+      std::fill(results, results + count, T(0));
+    }
+    for (int64_t offset = 0; offset < count; offset += chunk) {
+      int64_t n = std::min(chunk, count - offset);
+      if (target >= 0) {
+        std::memcpy(Buffer(rank_), values + offset, n * sizeof(T));
+      }
+      Barrier();
+      if (source >= 0) {
+        std::memcpy(results + offset, Buffer(source), n * sizeof(T));
+      }
+      NextBuffer();
+    }
+  });
+}
+
+}  // namespace lazy_tensors
@@ -0,0 +1,122 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef COMPUTATION_CLIENT_SHM_COLLECTIVES_H_
+#define COMPUTATION_CLIENT_SHM_COLLECTIVES_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "lazy_tensors/primitive_types.h"
+
+namespace lazy_tensors {
+
+// The collectives of the processes of a single host, through a POSIX shared
+// memory segment. Each rank owns a slot of the segment, split into a ring of
+// two buffers: a collective stages its data in chunks through the buffers, and
+// the ranks meet at a futex based barrier once a chunk is staged. A buffer is
+// only overwritten two chunks later, once all the ranks have passed the barrier
+// of the chunk in between, so a single barrier per chunk is enough (two for an
+// all-reduce). All the ranks of a communicator must run the same collectives in
+// the same order, with the same element counts.
+class ShmCommunicator {
+ public:
+  enum class ReduceOp {
+    kSum,
+    kProd,
+    kMin,
+    kMax,
+    kAnd,
+    kOr,
+  };
+
+  // Attaches to the segment of the given name (e.g., "/ratex_1234"), which rank
+  // 0 creates, and waits for all the ranks to attach. The slot of each rank
+  // holds slot_bytes, and waiting for the peers fails after timeout_s seconds.
+  ShmCommunicator(std::string name, int64_t rank, int64_t size,
+                  int64_t slot_bytes = kDefaultSlotBytes, double timeout_s = 300.0);
+
+  ~ShmCommunicator();
+
+  ShmCommunicator(const ShmCommunicator&) = delete;
+  ShmCommunicator& operator=(const ShmCommunicator&) = delete;
+
+  static constexpr int64_t kDefaultSlotBytes = 8 << 20;
+
+  // Parses one of "sum", "mul" (or "prod"), "min", "max", "and" and "or".
+  static ReduceOp ParseReduceOp(const std::string& name);
+
+  int64_t rank() const {
+    return rank_;
+  }
+
+  int64_t size() const {
+    return size_;
+  }
+
+  // Reduces the count elements of data across the ranks, in place. All the
+  // ranks get the same result, bit for bit.
+  void AllReduce(void* data, int64_t count, PrimitiveType type, ReduceOp op);
+
+  // Gathers the count elements of input of each rank into output, which holds
+  // size() * count elements in rank order.
+  void AllGather(const void* input, void* output, int64_t count, PrimitiveType type);
+
+  // Reduces the size() * count elements of input across the ranks, and stores
+  // the rank-th block of count elements of the result into output.
+  void ReduceScatter(const void* input, void* output, int64_t count, PrimitiveType type,
+                     ReduceOp op);
+
+  // Copies the count elements of data of the root rank to the other ranks.
+  void Broadcast(void* data, int64_t count, PrimitiveType type, int64_t root);
+
+  // Sends the i-th block of count elements of input to rank i, and receives the
+  // block of rank i into the i-th block of output. Both hold size() * count
+  // elements.
+  void AllToAll(const void* input, void* output, int64_t count, PrimitiveType type);
+
+  // Sends the count elements of input to the target rank, and receives the
+  // elements of the source rank into output. A negative target sends nothing,
+  // and a negative source fills output with zeros. The ranks must agree on the
+  // pairs, as in a collective permute.
+  void Permute(const void* input, void* output, int64_t count, PrimitiveType type,
+               int64_t source, int64_t target);
+
+  void Barrier();
+
+ private:
+  struct Header;
+
+  void Attach();
+
+  // Returns the buffer of the rank for the next chunk, which all the ranks
+  // select in the same order.
+  char* Buffer(int64_t rank) const;
+
+  void NextBuffer() {
+    ring_index_ ^= 1;
+  }
+
+  // The number of elements of a chunk staged in a single buffer, or in one of
+  // its size() segments if segmented.
+  int64_t ChunkElements(int64_t element_bytes, bool segmented) const;
+
+  std::string name_;
+  int64_t rank_ = 0;
+  int64_t size_ = 0;
+  int64_t slot_bytes_ = 0;
+  int64_t timeout_ns_ = 0;
+  size_t mapped_bytes_ = 0;
+  char* base_ = nullptr;
+  Header* header_ = nullptr;
+  int ring_index_ = 0;
+  // The collectives of a communicator run one at a time.
+  std::mutex mutex_;
+};
+
+}  // namespace lazy_tensors
+
+#endif  // COMPUTATION_CLIENT_SHM_COLLECTIVES_H_
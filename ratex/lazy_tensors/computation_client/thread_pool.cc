@@ -7,121 +7,618 @@
 
 #include "lazy_tensors/computation_client/thread_pool.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <deque>
 #include <exception>
 #include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "lazy_tensors/computation_client/debug_macros.h"
 #include "lazy_tensors/computation_client/ltc_logging.h"
 #include "lazy_tensors/computation_client/metrics.h"
+#include "lazy_tensors/computation_client/sys_util.h"
 
 namespace lazy_tensors {
 namespace env {
 namespace {
 
+class ThreadPool;
+
+// The pool and the index of the worker or reserve thread running on the
+// current thread, if any.
+thread_local ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+// The class of the running closure, -1 if none.
+thread_local int current_class = -1;
+// The number of nested blocking regions of the current thread.
+thread_local int blocking_depth = 0;
+// The priority of the closures scheduled without one by the current thread.
+thread_local Priority current_priority = Priority::kDefault;
+
+const char* const kPriorityNames[kNumPriorities] = {"execution", "transfer", "default",
+                                                   "background"};
+
+// Parses a list of CPUs like "0-3,8,10".
+std::vector<int> ParseCpuList(const std::string& cpu_list) {
+  std::vector<int> cpus;
+  size_t start = 0;
+  while (start < cpu_list.size()) {
+    size_t end = cpu_list.find(',', start);
+    if (end == std::string::npos) {
+      end = cpu_list.size();
+    }
+    std::string range = cpu_list.substr(start, end - start);
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+    start = end + 1;
+  }
+  return cpus;
+}
+
+// Parses the concurrency limits of the priority classes, like "background=2,transfer=4".
+// The background class is limited to half of the workers by default, so that the closures on
+// the critical path always find free workers.
+std::array<int64_t, kNumPriorities> ParseLimits(const std::string& limits, size_t num_threads) {
+  std::array<int64_t, kNumPriorities> result;
+  result.fill(num_threads);
+  result[static_cast<int>(Priority::kBackground)] = std::max<int64_t>(num_threads / 2, 1);
+  size_t start = 0;
+  while (start < limits.size()) {
+    size_t end = limits.find(',', start);
+    if (end == std::string::npos) {
+      end = limits.size();
+    }
+    std::string limit = limits.substr(start, end - start);
+    size_t equal = limit.find('=');
+    LTC_CHECK_NE(equal, std::string::npos) << "Invalid thread pool limit: " << limit;
+    int64_t value = std::stoll(limit.substr(equal + 1));
+    LTC_CHECK_GT(value, 0) << "Invalid thread pool limit: " << limit;
+    result[static_cast<int>(ParsePriority(limit.substr(0, equal)))] = value;
+    start = end + 1;
+  }
+  return result;
+}
+
+void SetAffinity(std::thread* thread, int cpu) {
+#ifdef __linux__
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  int rc = pthread_setaffinity_np(thread->native_handle(), sizeof(cpu_set), &cpu_set);
+  if (rc != 0) {
+    LTC_LOG(WARNING) << "Failed to pin a thread pool worker to CPU " << cpu << ": " << rc;
+  }
+#else
+  LTC_LOG(WARNING) << "Thread pool CPU affinity is not supported on this platform";
+#endif
+}
+
+// A fixed size pool where each worker has its own deques of closures, one per
+// priority class. The queued closures of the highest priority class run first:
+// a worker runs the closures it scheduled itself most recent first, then the
+// closures scheduled by other threads in order, and otherwise steals the oldest
+// closure of another worker. Closures scheduled while all the workers are busy,
+// or while their class runs as many closures as its limit, are queued.
+// As the workers may block in their closures, e.g. waiting for closures queued
+// behind them, the pool runs the queued closures on escape threads until there
+// is none left to run:
+// - When a pool thread enters a blocking region, or a closure is scheduled
+//   while one is in it, and no worker is idle to run the queued closures. A
+//   closure in a blocking region does not count toward the limit of its class.
+// - When closures can run and none finished for the stall interval, i.e. the
+//   pool threads block some other way or run long closures.
+// The escape threads also run the closures within the limits of their classes.
+// They are reserve threads started on demand up to max_escapes, each with its
+// own deques, which park once they run out of closures until the next escape,
+// so that the number of threads of the pool is bounded. As the escapes may then
+// not suffice, a pool thread about to block first runs the closures it
+// scheduled itself, which it is likely waiting for.
 class ThreadPool {
  public:
-  explicit ThreadPool(size_t num_threads) {
-    threads_.reserve(num_threads);
-    for (size_t i = 0; i < num_threads; ++i) {
-      threads_.emplace_back([this]() { Worker(); });
+  ThreadPool(const std::string& name, size_t num_threads, const std::vector<int>& cpus,
+             const std::array<int64_t, kNumPriorities>& limits, int64_t stall_ms,
+             int64_t max_escapes)
+      : num_workers_(std::max<size_t>(num_threads, 1)),
+        queues_(num_workers_ + max_escapes),
+        limits_(limits),
+        stall_interval_(std::chrono::milliseconds(stall_ms)),
+        max_escapes_(max_escapes),
+        queue_depth_metric_(name + "QueueDepth"),
+        task_latency_metric_(name + "TaskLatency", metrics::MetricFnTime),
+        threads_metric_(name + "Threads"),
+        steal_counter_(name + "Steals"),
+        escape_counter_(name + "EscapeThreads"),
+        escape_capped_counter_(name + "EscapeThreadsCapped") {
+    for (int i = 0; i < kNumPriorities; ++i) {
+      class_latency_metrics_.emplace_back(
+          new metrics::Metric(name + "TaskLatency:" + kPriorityNames[i], metrics::MetricFnTime));
     }
+    threads_.reserve(num_workers_);
+    for (size_t i = 0; i < num_workers_; ++i) {
+      threads_.emplace_back([this, i]() { Worker(i); });
+      if (!cpus.empty()) {
+        SetAffinity(&threads_.back(), cpus[i % cpus.size()]);
+      }
+    }
+    monitor_ = std::thread([this]() { Monitor(); });
   }
 
   ~ThreadPool() {
+    std::vector<std::thread> reserve_threads;
     {
       std::lock_guard<std::mutex> lock(mutex_);
       exiting_ = true;
-      cv_.notify_all();
+      reserve_threads.swap(reserve_threads_);
     }
+    cv_.notify_all();
+    monitor_cv_.notify_all();
+    reserve_cv_.notify_all();
     for (auto& thread : threads_) {
       thread.join();
     }
+    monitor_.join();
+    for (auto& thread : reserve_threads) {
+      thread.join();
+    }
   }
 
-  void Schedule(std::function<void()> closure) {
-    // If we have more work scheduled than waiting worker threads, just schedule
-    // it on a separate thread. This prevents tricky thread-pool-size-deadlocks
-    // caused by an undersized thread pool and closures that end up doing sync
-    // waits on the pool threads.
-    bool scheduled = false;
+  void Schedule(std::function<void()> closure, Priority priority) {
+    int index = static_cast<int>(priority);
+    Task task{std::move(closure), sys_util::NowNs(), priority};
+    bool from_worker = current_pool == this;
+    if (from_worker) {
+      WorkerQueue& queue = queues_[current_worker];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks[index].push_back(std::move(task));
+    }
+    int64_t pending = 0;
     {
+      // Updating the pending counts under the mutex makes sure that a worker
+      // going to sleep sees them.
       std::lock_guard<std::mutex> lock(mutex_);
-      if (work_.size() < waiting_) {
-        work_.emplace_back(std::move(closure));
-        scheduled = true;
+      if (!from_worker) {
+        injected_[index].push_back(std::move(task));
       }
+      ++pending_[index];
+      pending = PendingCount();
+      MaybeEscape();
     }
-    if (scheduled) {
+    queue_depth_metric_.AddSample(pending);
+    cv_.notify_one();
+  }
+
+  // Runs a closure the current pool thread scheduled itself, if any within the
+  // limits of the classes. Called in the blocking region of the closure waiting
+  // for it, out of which the closure runs.
+  bool RunOwnTask() {
+    for (int i = 0; i < kNumPriorities; ++i) {
+      if (!ReserveTask(i)) {
+        continue;
+      }
+      Task task;
+      if (PopOwnTask(current_worker, i, &task)) {
+        int depth = blocking_depth;
+        blocking_depth = 0;
+        ExitBlocking(/*task_class=*/-1);
+        Run(&task);
+        EnterBlocking(/*task_class=*/-1);
+        blocking_depth = depth;
+        return true;
+      }
+      ReleaseTask(i, /*pending=*/true);
+    }
+    return false;
+  }
+
+  // Called by a pool thread entering and leaving a blocking region, with the
+  // class of its closure, -1 if none.
+  void EnterBlocking(int task_class) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++blocked_;
+      if (task_class >= 0) {
+        --running_[task_class];
+      }
+      MaybeEscape();
+    }
+    if (task_class >= 0) {
+      // A task of the class may be waiting for the limit.
       cv_.notify_one();
-    } else {
-      ScheduleOnThread(std::move(closure));
+    }
+  }
+
+  void ExitBlocking(int task_class) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    --blocked_;
+    if (task_class >= 0) {
+      ++running_[task_class];
     }
   }
 
  private:
-  void Worker() {
+  struct Task {
+    std::function<void()> closure;
+    int64_t schedule_ns = 0;
+    Priority priority = Priority::kDefault;
+  };
+
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks[kNumPriorities];
+  };
+
+  void Worker(size_t index) {
+    current_pool = this;
+    current_worker = index;
     while (true) {
-      std::function<void()> closure = GetWork();
-      if (closure == nullptr) {
-        break;
+      Task task;
+      if (GetTask(index, &task)) {
+        Run(&task);
+        continue;
       }
-      try {
-        closure();
-      } catch (const std::exception& ex) {
-        LTC_COUNTER("ThreadPoolException", 1);
-        LTC_LOG(ERROR) << "Exception from running thread pool closure: " << ex.what();
+      std::unique_lock<std::mutex> lock(mutex_);
+      ++idle_;
+      cv_.wait(lock, [this] { return exiting_ || HasRunnableTask(); });
+      --idle_;
+      if (exiting_ && !HasRunnableTask()) {
+        break;
       }
     }
   }
 
-  void ScheduleOnThread(std::function<void()> closure) {
-    std::thread thread(std::move(closure));
-    thread.detach();
+  // Runs the queued closures while escaping, and parks in between.
+  void Reserve(size_t index) {
+    current_pool = this;
+    current_worker = index;
+    while (true) {
+      Task task;
+      if (GetTask(index, &task)) {
+        Run(&task);
+        continue;
+      }
+      // Checking under the mutex makes sure that no closure is scheduled after
+      // the thread gave up on the deques and before it parks.
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (HasRunnableTask()) {
+        continue;
+      }
+      --escapes_;
+      ++parked_;
+      reserve_cv_.wait(lock, [this] { return exiting_ || wakeups_ > 0; });
+      if (wakeups_ == 0) {
+        --parked_;
+        break;
+      }
+      // The waking thread took this thread off the parked ones.
+      --wakeups_;
+    }
   }
 
-  std::function<void()> GetWork() {
+  // Starts an escape when closures can run and none finished for the stall
+  // interval, i.e. the pool threads block some other way than in a blocking
+  // region, or run long closures.
+  void Monitor() {
     std::unique_lock<std::mutex> lock(mutex_);
-    ++waiting_;
-    cv_.wait(lock, [this] { return exiting_ || !work_.empty(); });
-    --waiting_;
-    if (work_.empty()) {
-      return nullptr;
+    int64_t last_finished = -1;
+    while (!monitor_cv_.wait_for(lock, stall_interval_, [this] { return exiting_; })) {
+      int64_t finished = finished_.load();
+      if (HasRunnableTask() && finished == last_finished) {
+        if (escapes_ >= max_escapes_ && !warned_capped_) {
+          LTC_LOG(WARNING) << "Thread pool stalled with " << max_escapes_
+                           << " escape threads, consider raising LTC_THREAD_POOL_MAX_ESCAPES";
+          warned_capped_ = true;
+        }
+        StartEscape();
+      }
+      last_finished = finished;
+    }
+  }
+
+  // Must be called with mutex_ held.
+  int64_t PendingCount() const {
+    int64_t pending = 0;
+    for (int64_t count : pending_) {
+      pending += count;
     }
-    std::function<void()> closure(std::move(work_.front()));
-    work_.pop_front();
-    return closure;
+    return pending;
   }
 
+  // Starts an escape thread if closures can run while no worker is idle and
+  // more threads are blocked in blocking regions than escape threads run. Must
+  // be called with mutex_ held.
+  void MaybeEscape() {
+    if (idle_ == 0 && blocked_ > escapes_ && HasRunnableTask()) {
+      StartEscape();
+    }
+  }
+
+  // Wakes up a parked reserve thread, or starts a new one, unless max_escapes_
+  // of them already escape. Must be called with mutex_ held.
+  void StartEscape() {
+    if (exiting_) {
+      return;
+    }
+    if (escapes_ >= max_escapes_) {
+      escape_capped_counter_.AddValue(1);
+      return;
+    }
+    ++escapes_;
+    escape_counter_.AddValue(1);
+    if (parked_ > 0) {
+      --parked_;
+      ++wakeups_;
+      reserve_cv_.notify_one();
+    } else {
+      size_t index = num_workers_ + reserve_threads_.size();
+      reserve_threads_.emplace_back([this, index]() { Reserve(index); });
+    }
+    threads_metric_.AddSample(threads_.size() + escapes_);
+  }
+
+  // Must be called with mutex_ held.
+  bool HasRunnableTask() const {
+    for (int i = 0; i < kNumPriorities; ++i) {
+      if (pending_[i] > 0 && running_[i] < limits_[i]) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Gets the next task of the given worker, within the limits of the classes.
+  bool GetTask(size_t worker, Task* task) {
+    for (int i = 0; i < kNumPriorities; ++i) {
+      // A reserved task is found in the deques, unless other workers pop the
+      // tasks of a deque after the scan passed it, in which case it retries.
+      while (ReserveTask(i)) {
+        if (PopTask(worker, i, task)) {
+          return true;
+        }
+        ReleaseTask(i, /*pending=*/true);
+      }
+    }
+    return false;
+  }
+
+  bool ReserveTask(int index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_[index] == 0 || running_[index] >= limits_[index]) {
+      return false;
+    }
+    --pending_[index];
+    ++running_[index];
+    return true;
+  }
+
+  void ReleaseTask(int index, bool pending) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --running_[index];
+      if (pending) {
+        ++pending_[index];
+      }
+    }
+    // A task of the class may be waiting for the limit.
+    cv_.notify_one();
+  }
+
+  // The escape threads steal the closures scheduled by the workers before the
+  // ones scheduled from outside the pool, as the blocked closures are likely
+  // waiting for the former.
+  bool PopTask(size_t worker, int index, Task* task) {
+    bool escape = worker >= num_workers_;
+    if (PopOwnTask(worker, index, task)) {
+      return true;
+    }
+    if (!escape && PopInjectedTask(index, task)) {
+      return true;
+    }
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      WorkerQueue& victim = queues_[(worker + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks[index].empty()) {
+        *task = std::move(victim.tasks[index].front());
+        victim.tasks[index].pop_front();
+        steal_counter_.AddValue(1);
+        return true;
+      }
+    }
+    return escape && PopInjectedTask(index, task);
+  }
+
+  // Pops the closure the given thread scheduled last.
+  bool PopOwnTask(size_t worker, int index, Task* task) {
+    WorkerQueue& queue = queues_[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks[index].empty()) {
+      return false;
+    }
+    *task = std::move(queue.tasks[index].back());
+    queue.tasks[index].pop_back();
+    return true;
+  }
+
+  bool PopInjectedTask(int index, Task* task) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (injected_[index].empty()) {
+      return false;
+    }
+    *task = std::move(injected_[index].front());
+    injected_[index].pop_front();
+    return true;
+  }
+
+  void Run(Task* task) {
+    int index = static_cast<int>(task->priority);
+    int64_t latency_ns = sys_util::NowNs() - task->schedule_ns;
+    task_latency_metric_.AddSample(latency_ns);
+    class_latency_metrics_[index]->AddSample(latency_ns);
+    Priority parent_priority = current_priority;
+    current_priority = task->priority;
+    int parent_class = current_class;
+    current_class = index;
+    try {
+      task->closure();
+    } catch (const std::exception& ex) {
+      LTC_COUNTER("ThreadPoolException", 1);
+      LTC_LOG(ERROR) << "Exception from running thread pool closure: " << ex.what();
+    }
+    ++finished_;
+    current_priority = parent_priority;
+    current_class = parent_class;
+    ReleaseTask(index, /*pending=*/false);
+  }
+
+  const size_t num_workers_;
   std::vector<std::thread> threads_;
+  // The deques of the workers, followed by the ones of the reserve threads.
+  std::vector<WorkerQueue> queues_;
+  std::thread monitor_;
+  // The reserve threads running the escapes, started on demand.
+  std::vector<std::thread> reserve_threads_;
+  // Protects the closures scheduled from outside the pool, the pending and the
+  // running counts, the thread counts and the exiting flag.
   std::mutex mutex_;
   std::condition_variable cv_;
+  std::condition_variable monitor_cv_;
+  std::condition_variable reserve_cv_;
   bool exiting_ = false;
-  std::deque<std::function<void()>> work_;
-  size_t waiting_ = 0;
+  bool warned_capped_ = false;
+  // The number of idle workers, of pool threads in blocking regions, of
+  // escaping reserve threads, of parked reserve threads and of the parked ones
+  // woken up to escape.
+  int64_t idle_ = 0;
+  int64_t blocked_ = 0;
+  int64_t escapes_ = 0;
+  int64_t parked_ = 0;
+  int64_t wakeups_ = 0;
+  // The number of closures finished, to detect stalls.
+  std::atomic<int64_t> finished_{0};
+  std::deque<Task> injected_[kNumPriorities];
+  // The number of closures of each class scheduled and not started yet.
+  int64_t pending_[kNumPriorities] = {};
+  // The number of closures of each class running toward the limits.
+  int64_t running_[kNumPriorities] = {};
+  const std::array<int64_t, kNumPriorities> limits_;
+  const std::chrono::milliseconds stall_interval_;
+  const int64_t max_escapes_;
+  metrics::Metric queue_depth_metric_;
+  metrics::Metric task_latency_metric_;
+  // The number of workers and escaping reserve threads, sampled at every escape.
+  metrics::Metric threads_metric_;
+  std::vector<std::unique_ptr<metrics::Metric>> class_latency_metrics_;
+  metrics::Counter steal_counter_;
+  metrics::Counter escape_counter_;
+  metrics::Counter escape_capped_counter_;
 };
 
+ThreadPool* CreateThreadPool(const std::string& name, const char* size_env,
+                             const char* affinity_env, const char* limits_env) {
+  size_t num_threads = sys_util::GetEnvInt(size_env, std::thread::hardware_concurrency());
+  std::vector<int> cpus = ParseCpuList(sys_util::GetEnvString(affinity_env, ""));
+  std::array<int64_t, kNumPriorities> limits =
+      ParseLimits(sys_util::GetEnvString(limits_env, ""), std::max<size_t>(num_threads, 1));
+  int64_t stall_ms = sys_util::GetEnvInt("LTC_THREAD_POOL_STALL_MS", 100);
+  LTC_CHECK_GT(stall_ms, 0) << "Invalid LTC_THREAD_POOL_STALL_MS: " << stall_ms;
+  int64_t max_escapes =
+      sys_util::GetEnvInt("LTC_THREAD_POOL_MAX_ESCAPES", std::max<size_t>(num_threads, 1));
+  LTC_CHECK_GT(max_escapes, 0) << "Invalid LTC_THREAD_POOL_MAX_ESCAPES: " << max_escapes;
+  return new ThreadPool(name, num_threads, cpus, limits, stall_ms, max_escapes);
+}
+
 ThreadPool* GetThreadPool() {
-  static size_t num_threads =
-      sys_util::GetEnvInt("LTC_THREAD_POOL_SIZE", std::thread::hardware_concurrency());
-  static ThreadPool* pool = new ThreadPool(num_threads);
+  static ThreadPool* pool = CreateThreadPool("ThreadPool", "LTC_THREAD_POOL_SIZE",
+                                             "LTC_THREAD_POOL_AFFINITY", "LTC_THREAD_POOL_LIMITS");
   return pool;
 }
 
 ThreadPool* GetIoThreadPool() {
-  static size_t num_threads =
-      sys_util::GetEnvInt("LTC_IO_THREAD_POOL_SIZE", std::thread::hardware_concurrency());
-  static ThreadPool* pool = new ThreadPool(num_threads);
+  static ThreadPool* pool =
+      CreateThreadPool("IoThreadPool", "LTC_IO_THREAD_POOL_SIZE", "LTC_IO_THREAD_POOL_AFFINITY",
+                       "LTC_IO_THREAD_POOL_LIMITS");
   return pool;
 }
 
 }  // namespace
 
+const char* PriorityName(Priority priority) {
+  return kPriorityNames[static_cast<int>(priority)];
+}
+
+Priority ParsePriority(const std::string& name) {
+  for (int i = 0; i < kNumPriorities; ++i) {
+    if (name == kPriorityNames[i]) {
+      return static_cast<Priority>(i);
+    }
+  }
+  throw std::invalid_argument("Invalid closure priority: " + name);
+}
+
+Priority GetThreadPriority() {
+  return current_priority;
+}
+
+Priority SetThreadPriority(Priority priority) {
+  Priority previous = current_priority;
+  current_priority = priority;
+  return previous;
+}
+
+BlockingRegion::BlockingRegion() {
+  if (blocking_depth++ == 0 && current_pool != nullptr) {
+    current_pool->EnterBlocking(current_class);
+  }
+}
+
+BlockingRegion::~BlockingRegion() {
+  if (--blocking_depth == 0 && current_pool != nullptr) {
+    current_pool->ExitBlocking(current_class);
+  }
+}
+
+void BlockingWait(std::unique_lock<std::mutex>* lock, std::condition_variable* cv,
+                  const std::function<bool()>& done) {
+  if (done()) {
+    return;
+  }
+  BlockingRegion region;
+  // A pool thread first runs the closures it scheduled itself, which it is
+  // likely waiting for, as the escape threads are bounded.
+  if (current_pool != nullptr) {
+    bool ran = true;
+    while (ran) {
+      lock->unlock();
+      ran = current_pool->RunOwnTask();
+      lock->lock();
+      if (done()) {
+        return;
+      }
+    }
+  }
+  cv->wait(*lock, done);
+}
+
 class Completion::Data {
  public:
   void Wait() {
     std::unique_lock<std::mutex> lock(mutex_);
-    cv_.wait(lock, [this] { return completed_; });
+    BlockingWait(&lock, &cv_, [this] { return completed_; });
     if (exptr_ != nullptr) {
       std::rethrow_exception(exptr_);
     }
@@ -165,23 +662,23 @@ void Completion::Wait() {
   data_->Wait();
 }
 
-void ScheduleClosure(std::function<void()> closure) {
-  GetThreadPool()->Schedule(std::move(closure));
+void ScheduleClosure(std::function<void()> closure, Priority priority) {
+  GetThreadPool()->Schedule(std::move(closure), priority);
 }
 
-void ScheduleIoClosure(std::function<void()> closure) {
-  GetIoThreadPool()->Schedule(std::move(closure));
+void ScheduleIoClosure(std::function<void()> closure, Priority priority) {
+  GetIoThreadPool()->Schedule(std::move(closure), priority);
 }
 
-Completion ScheduleClosureWithCompletion(std::function<void()> closure) {
+Completion ScheduleClosureWithCompletion(std::function<void()> closure, Priority priority) {
   auto data = std::make_shared<Completion::Data>();
-  GetThreadPool()->Schedule(Completion::Data::GetCompleter(data, std::move(closure)));
+  GetThreadPool()->Schedule(Completion::Data::GetCompleter(data, std::move(closure)), priority);
   return Completion(std::move(data));
 }
 
-Completion ScheduleIoClosureWithCompletion(std::function<void()> closure) {
+Completion ScheduleIoClosureWithCompletion(std::function<void()> closure, Priority priority) {
   auto data = std::make_shared<Completion::Data>();
-  GetIoThreadPool()->Schedule(Completion::Data::GetCompleter(data, std::move(closure)));
+  GetIoThreadPool()->Schedule(Completion::Data::GetCompleter(data, std::move(closure)), priority);
   return Completion(std::move(data));
 }
 
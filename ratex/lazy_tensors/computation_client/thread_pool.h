@@ -8,8 +8,11 @@
 #ifndef COMPUTATION_CLIENT_THREAD_POOL_H_
 #define COMPUTATION_CLIENT_THREAD_POOL_H_
 
+#include <condition_variable>
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 
 namespace lazy_tensors {
@@ -29,14 +32,84 @@ class Completion {
   std::shared_ptr<Data> data_;
 };
 
+// The priority classes of the scheduled closures. The queued closures of a
+// class run before the ones of the classes after it, and each class can be
+// limited to a number of concurrent closures per pool (LTC_THREAD_POOL_LIMITS
+// and LTC_IO_THREAD_POOL_LIMITS, e.g., "background=2,transfer=4").
+enum class Priority {
+  // The graph executions, on the critical path of the steps.
+  kExecution,
+  // The device to host copies the host is about to wait for.
+  kTransfer,
+  kDefault,
+  // The work nobody waits for yet, like the uploads of the data loaders. Limited
+  // to half of the pool by default.
+  kBackground,
+};
+
+constexpr int kNumPriorities = 4;
+
+// The names of the priority classes are "execution", "transfer", "default" and
+// "background".
+const char* PriorityName(Priority priority);
+Priority ParsePriority(const std::string& name);
+
+// Returns the priority of the closures scheduled by the current thread without
+// an explicit one. On a pool thread, this is the priority of the running
+// closure, so the closures it fans out inherit it.
+Priority GetThreadPriority();
+
+// Sets the priority of the closures scheduled by the current thread without an
+// explicit one, and returns the previous one.
+Priority SetThreadPriority(Priority priority);
+
+class ScopedPriority {
+ public:
+  explicit ScopedPriority(Priority priority) : previous_(SetThreadPriority(priority)) {
+  }
+
+  ~ScopedPriority() {
+    SetThreadPriority(previous_);
+  }
+
+ private:
+  Priority previous_;
+};
+
 // Schedules a closure to be run. The closure should not block waiting for other
 // events.
-void ScheduleClosure(std::function<void()> closure);
-Completion ScheduleClosureWithCompletion(std::function<void()> closure);
+void ScheduleClosure(std::function<void()> closure, Priority priority = GetThreadPriority());
+Completion ScheduleClosureWithCompletion(std::function<void()> closure,
+                                         Priority priority = GetThreadPriority());
 
 // Schedules a closure which might wait for IO or other events/conditions.
-void ScheduleIoClosure(std::function<void()> closure);
-Completion ScheduleIoClosureWithCompletion(std::function<void()> closure);
+void ScheduleIoClosure(std::function<void()> closure, Priority priority = GetThreadPriority());
+Completion ScheduleIoClosureWithCompletion(std::function<void()> closure,
+                                           Priority priority = GetThreadPriority());
+
+// The thread pools have a fixed number of workers (LTC_THREAD_POOL_SIZE and
+// LTC_IO_THREAD_POOL_SIZE), and queue the closures scheduled while all of them
+// are busy. A closure blocked on other closures would hold its worker, so a
+// pool runs its queued closures on one of up to LTC_THREAD_POOL_MAX_ESCAPES
+// reserve threads (the number of workers by default) when its workers are
+// blocked. A closure that blocks should do so within a BlockingRegion (or
+// through BlockingWait()), which lets the pool escape right away and releases
+// the slot of the closure in the limit of its class; otherwise the pool only
+// escapes once no closure finished for LTC_THREAD_POOL_STALL_MS milliseconds
+// (100 by default), within the limits of the classes.
+
+// Marks the current thread as blocked while in scope.
+class BlockingRegion {
+ public:
+  BlockingRegion();
+
+  ~BlockingRegion();
+};
+
+// Waits on cv until done() returns true within a BlockingRegion. The lock must
+// hold the mutex of cv.
+void BlockingWait(std::unique_lock<std::mutex>* lock, std::condition_variable* cv,
+                  const std::function<bool()>& done);
 
 }  // namespace env
 }  // namespace lazy_tensors
@@ -7,6 +7,8 @@
 
 #include "lazy_tensors/literal.h"
 
+#include <ATen/Functions.h>
+
 #include "lazy_tensors/computation_client/util.h"
 #include "lazy_tensors/core/platform/hash.h"
 #include "lazy_tensors/shape_util.h"
@@ -19,6 +21,26 @@ Literal::Literal(const Shape& shape) : shape_(shape) {
   value_ = at::empty(dimensions, options);
 }
 
+Literal::Literal(const Shape& shape, at::Tensor value, bool borrowed)
+    : value_(std::move(value)), shape_(shape), borrowed_(borrowed) {
+  LTC_CHECK_EQ(value_.numel(), ShapeUtil::ElementsIn(shape_)) << shape_;
+  LTC_CHECK_EQ(value_.scalar_type(), PrimitiveToScalarType(shape_.element_type())) << shape_;
+}
+
+Literal Literal::FromBuffer(const Shape& shape, void* data, std::function<void(void*)> deleter,
+                            bool borrowed) {
+  std::vector<int64_t> dimensions = util::ToVector<int64_t>(shape.dimensions());
+  std::vector<int64_t> strides(dimensions.size());
+  int64_t stride = 1;
+  for (auto dim : shape.layout().minor_to_major()) {
+    strides[dim] = stride;
+    stride *= dimensions[dim];
+  }
+  at::TensorOptions options(PrimitiveToScalarType(shape.element_type()));
+  return Literal(shape, at::from_blob(data, dimensions, strides, std::move(deleter), options),
+                 borrowed);
+}
+
 const Shape& Literal::shape() const {
   return shape_;
 }
@@ -11,6 +11,7 @@
 #include <ATen/core/Tensor.h>
 #include <ATen/native/TensorFactories.h>
 
+#include <functional>
 #include <string>
 
 #include "lazy_tensors/shape.h"
@@ -26,6 +27,18 @@ class Literal {
 
   explicit Literal(const Shape& shape);
 
+  // Creates a literal whose storage is the given tensor, without copying it.
+  // A borrowed storage belongs to a buffer owned elsewhere (e.g., a device
+  // buffer), which may be updated after the literal is created.
+  Literal(const Shape& shape, at::Tensor value, bool borrowed = false);
+
+  // Creates a literal over an external buffer (e.g., a device buffer or a
+  // mapped file) in the layout of the shape, without copying it. The deleter
+  // is called with the data once the literal, and all the tensors sharing its
+  // storage, are destroyed.
+  static Literal FromBuffer(const Shape& shape, void* data, std::function<void(void*)> deleter,
+                            bool borrowed = true);
+
   const Shape& shape() const;
 
   template <typename NativeT>
@@ -80,9 +93,14 @@ class Literal {
     return value_;
   }
 
+  bool is_borrowed() const {
+    return borrowed_;
+  }
+
  private:
   at::Tensor value_;
   Shape shape_;
+  bool borrowed_ = false;
 };
 
 template <>
@@ -188,6 +188,7 @@ def dryrun_dumped_ir_file(orig_test):
                     "RATEX_DRY_RUN": "true",
                     "RATEX_SAVE_IR_FILE": str(Path(temp_dir) / "module.json"),
                     "RATEX_DUMP_ALIAS": str(Path(temp_dir) / "alias.txt"),
+                    "RATEX_DRY_RUN_REPORT": str(Path(temp_dir) / "dryrun_report"),
                 },
             ):
                 return orig_test(*args, **kwargs)
@@ -0,0 +1,59 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Benchmark the element copies and conversions of the lazy tensor transfers.
+
+Reports the upload (host to device) and download (device to host) throughput of each dtype.
+The device stores the tensors in the same dtype unless LTC_USE_BF16, LTC_USE_FP16 or
+LTC_USE_32BIT_LONG is set, in which case the F32->BF16, F32/F64->F16 or S64->S32 conversion
+pairs are measured instead.
+
+    LTC_USE_BF16=1 python3 scripts/benchmark/dtype_conversion.py --dtypes float32 --numel 16777216
+"""
+import argparse
+import os
+import time
+
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+
+
+def bench(fn, repeat):
+    fn()
+    elapsed = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        fn()
+        elapsed.append(time.perf_counter() - start)
+    return min(elapsed)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "--dtypes",
+        nargs="+",
+        default=["bool", "int8", "int16", "int32", "int64", "float16", "bfloat16", "float32"],
+    )
+    parser.add_argument("--numel", type=int, default=1 << 24)
+    parser.add_argument("--repeat", type=int, default=5)
+    args = parser.parse_args()
+
+    device = lm.lazy_device()
+    env_vars = ("LTC_USE_BF16", "LTC_USE_FP16", "LTC_USE_32BIT_LONG")
+    env = [name for name in env_vars if os.getenv(name)]
+    print(f"device storage: {', '.join(env) or 'same dtype'}")
+    print(f"{'dtype':>10} {'upload (GB/s)':>14} {'download (GB/s)':>16}")
+    for name in args.dtypes:
+        dtype = getattr(torch, name)
+        x = torch.ones(args.numel, dtype=dtype)
+        nbytes = x.numel() * x.element_size()
+        upload = bench(lambda: lm.send_cpu_data_to_device(x, device), args.repeat)
+        x_lazy = x.to(device)
+        download = bench(lambda: lm._maybe_convert_to_cpu(x_lazy), args.repeat)
+        print(f"{name:>10} {nbytes / upload / 1e9:>14.3f} {nbytes / download / 1e9:>16.3f}")
+
+
+if __name__ == "__main__":
+    main()
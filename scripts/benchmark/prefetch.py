@@ -0,0 +1,81 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Benchmark the latency of the asynchronous fetches under concurrent load.
+
+Several Python threads run small steps and read their losses with `prefetch_to_host`, so that
+many executions and fetches are in flight at once. The fetches are continuations of the
+executions, so the number of OS threads must stay at the size of the thread pools however many
+fetches are pending. Reports the latency percentiles of the fetches and the peak number of OS
+threads of the process.
+
+    LTC_IO_THREAD_POOL_SIZE=4 python3 scripts/benchmark/prefetch.py --clients 16 --inflight 8
+"""
+
+import argparse
+import threading
+import time
+
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+
+
+def num_os_threads():
+    with open("/proc/self/status") as status:
+        for line in status:
+            if line.startswith("Threads:"):
+                return int(line.split()[1])
+    return 0
+
+
+def client(device, args, latencies):
+    x = torch.randn(args.size, args.size).to(device)
+    pending = []
+    for _ in range(args.steps):
+        loss = (x @ x).sum()
+        pending.append((time.perf_counter(), lm.prefetch_to_host(loss)))
+        # Keep a bounded number of fetches in flight, like a training loop logging every step.
+        while len(pending) > args.inflight:
+            start, future = pending.pop(0)
+            future.result()
+            latencies.append(time.perf_counter() - start)
+    for start, future in pending:
+        future.result()
+        latencies.append(time.perf_counter() - start)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--clients", type=int, default=8)
+    parser.add_argument("--steps", type=int, default=50)
+    parser.add_argument("--inflight", type=int, default=4)
+    parser.add_argument("--size", type=int, default=256)
+    args = parser.parse_args()
+
+    device = lm.lazy_device()
+    peak_threads = num_os_threads()
+    latencies = []
+    clients = [
+        threading.Thread(target=client, args=(device, args, latencies)) for _ in range(args.clients)
+    ]
+    start = time.perf_counter()
+    for thread in clients:
+        thread.start()
+    while any(thread.is_alive() for thread in clients):
+        peak_threads = max(peak_threads, num_os_threads())
+        time.sleep(0.001)
+    total = time.perf_counter() - start
+
+    latencies.sort()
+    percentile = lambda p: latencies[min(len(latencies) - 1, int(p * len(latencies)))] * 1e3
+    print(f"clients: {args.clients}, fetches: {len(latencies)}, total time: {total:.3f}s")
+    print(
+        f"fetch latency (ms): p50 {percentile(0.5):.2f}, p90 {percentile(0.9):.2f}, "
+        f"p99 {percentile(0.99):.2f}"
+    )
+    print(f"peak OS threads: {peak_threads}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,96 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Benchmark the shared memory collectives with N local processes.
+
+Launches one process per rank, which run each collective on host tensors of growing sizes through
+the shared memory communicator, and reports the latency and the algorithm bandwidth (the bytes of
+the input of a rank over the time) measured by rank 0. These are the host collectives of
+RATEX_COLLECTIVE_BACKEND=shm, which checks the numerical results of the distributed code paths: the
+numbers do not predict the collectives lowered into the graphs (e.g., NCCL on GPUs). They also
+leave out the host round trip of the lazy tensors, which every shm collective pays in a step.
+
+    RATEX_SHM_SLOT_SIZE=16 python3 scripts/benchmark/shm_collectives.py --ranks 4
+"""
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+import torch
+
+
+def run_rank(args):
+    from ratex.core import shm_collectives
+
+    comm = shm_collectives.get_communicator()
+    rank, size = comm.rank, comm.size
+    if rank == 0:
+        print(
+            "note: host tensors only. In a step, every shm collective also fetches its inputs to "
+            "the host and uploads its outputs back, cutting the step graph, so these numbers are "
+            "not the cost of a collective in training and are no substitute for NCCL/MPI."
+        )
+        print(f"ranks: {size}, dtype: {args.dtype}")
+        print(f"{'collective':>16} {'bytes':>12} {'latency (us)':>14} {'bandwidth (GB/s)':>18}")
+    dtype = getattr(torch, args.dtype)
+    itemsize = torch.empty((), dtype=dtype).element_size()
+    collectives = {
+        "all_reduce": lambda x, out: comm.all_reduce(x, "sum"),
+        "all_gather": lambda x, out: comm.all_gather(x, out),
+        "reduce_scatter": lambda x, out: comm.reduce_scatter(out, x, "sum"),
+        "broadcast": lambda x, out: comm.broadcast(x, 0),
+        "all_to_all": lambda x, out: comm.all_to_all(x, x.clone()),
+        # A ring, where each rank sends to the next one and receives from the previous one.
+        "permute": lambda x, out: comm.permute(
+            x, out[: x.numel()], (rank - 1) % size, (rank + 1) % size
+        ),
+    }
+    for name, collective in collectives.items():
+        numel = 1024
+        while numel * itemsize <= args.max_bytes:
+            x = torch.ones(numel * size, dtype=dtype)[: numel if name != "all_to_all" else None]
+            out = torch.empty(numel * size, dtype=dtype)
+            for _ in range(args.warmup):
+                collective(x, out)
+            comm.barrier()
+            start = time.perf_counter()
+            for _ in range(args.iters):
+                collective(x, out)
+            elapsed = (time.perf_counter() - start) / args.iters
+            if rank == 0:
+                nbytes = x.numel() * itemsize
+                bandwidth = nbytes / elapsed / 1e9
+                print(f"{name:>16} {nbytes:>12} {elapsed * 1e6:>14.1f} {bandwidth:>18.2f}")
+            numel *= 4
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--ranks", type=int, default=4)
+    parser.add_argument("--dtype", default="float32")
+    parser.add_argument("--max-bytes", type=int, default=64 << 20)
+    parser.add_argument("--iters", type=int, default=20)
+    parser.add_argument("--warmup", type=int, default=3)
+    parser.add_argument("--rank", type=int, default=None, help=argparse.SUPPRESS)
+    args = parser.parse_args()
+
+    if args.rank is not None:
+        run_rank(args)
+        return
+    workers = []
+    for rank in range(args.ranks):
+        env = dict(
+            os.environ,
+            RATEX_SHM_NAME=f"ratex_benchmark_{os.getpid()}",
+            RATEX_SHM_RANK=str(rank),
+            RATEX_SHM_WORLD_SIZE=str(args.ranks),
+        )
+        command = [sys.executable] + sys.argv + ["--rank", str(rank)]
+        workers.append(subprocess.Popen(command, env=env))
+    sys.exit(max(worker.wait() for worker in workers))
+
+
+if __name__ == "__main__":
+    main()
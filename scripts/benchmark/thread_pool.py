@@ -0,0 +1,89 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Benchmark the thread pools of the lazy tensor runtime with a bursty workload.
+
+Several Python threads concurrently move batches of tensors to the lazy device and fetch large
+transposed tensors back, which schedule many copies and transfers on the pools at once. Reports
+the throughput, the peak number of OS threads of the process, the peak number of threads of each
+pool including its escape threads, and the thread pool metrics.
+
+    LTC_THREAD_POOL_SIZE=8 python3 scripts/benchmark/thread_pool.py --clients 16
+"""
+
+import argparse
+import threading
+import time
+
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.debug.metrics as metrics
+
+
+def num_os_threads():
+    with open("/proc/self/status") as status:
+        for line in status:
+            if line.startswith("Threads:"):
+                return int(line.split()[1])
+    return 0
+
+
+def client(device, args, elapsed):
+    batch = [torch.randn(args.numel) for _ in range(args.batch)]
+    large = torch.randn(args.rows, args.rows).t()
+    start = time.perf_counter()
+    for _ in range(args.steps):
+        lm.send_cpu_data_to_device(batch, device)
+        large_lazy = lm.send_cpu_data_to_device(large, device)
+        lm._maybe_convert_to_cpu(large_lazy)
+    elapsed.append(time.perf_counter() - start)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--clients", type=int, default=8)
+    parser.add_argument("--steps", type=int, default=20)
+    parser.add_argument("--batch", type=int, default=64)
+    parser.add_argument("--numel", type=int, default=1 << 12)
+    parser.add_argument("--rows", type=int, default=2048)
+    args = parser.parse_args()
+
+    device = lm.lazy_device()
+    peak_threads = num_os_threads()
+    elapsed = []
+    clients = [
+        threading.Thread(target=client, args=(device, args, elapsed)) for _ in range(args.clients)
+    ]
+    start = time.perf_counter()
+    for thread in clients:
+        thread.start()
+    while any(thread.is_alive() for thread in clients):
+        peak_threads = max(peak_threads, num_os_threads())
+        time.sleep(0.001)
+    total = time.perf_counter() - start
+
+    nbytes = 4 * (args.batch * args.numel + 2 * args.rows * args.rows)
+    nbytes *= args.clients * args.steps
+    print(f"clients: {args.clients}, total time: {total:.3f}s")
+    print(f"throughput: {nbytes / total / 1e9:.3f} GB/s, slowest client: {max(elapsed):.3f}s")
+    print(f"peak OS threads: {peak_threads}")
+    for pool in ("ThreadPool", "IoThreadPool"):
+        for name in ("QueueDepth", "TaskLatency"):
+            if pool + name in metrics.metric_names():
+                count, total_value, samples = metrics.metric_data(pool + name)
+                peak = max((value for _, value in samples), default=0)
+                print(
+                    f"{pool + name}: samples {count}, mean {total_value / max(count, 1):.1f}, "
+                    f"peak of recent {peak:.1f}"
+                )
+        # The threads of a pool, its workers and escape threads, are sampled at every escape.
+        if pool + "Threads" in metrics.metric_names():
+            _, _, samples = metrics.metric_data(pool + "Threads")
+            print(f"{pool}Threads: peak of recent {max(value for _, value in samples):.0f}")
+        for name in ("Steals", "EscapeThreads", "EscapeThreadsCapped"):
+            print(f"{pool + name}: {metrics.counter_value(pool + name) or 0}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,55 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+"""Benchmark the host-to-device transfers of lazy tensors.
+
+Sweeps the number and the size of the tensors moved to the lazy device in one batch (as done
+by send_cpu_data_to_device) and reports the latency and the throughput of each configuration.
+
+    python3 scripts/benchmark/transfer_to_server.py --counts 1 16 256 --sizes 1024 1048576
+"""
+import argparse
+import time
+
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+
+
+def bench(count, nbytes, device, repeat):
+    numel = max(nbytes // 4, 1)
+    tensors = [torch.randn(numel) for _ in range(count)]
+    # Warm up the staging buffers and the IO threads.
+    lm.send_cpu_data_to_device(tensors, device)
+    elapsed = []
+    for _ in range(repeat):
+        start = time.perf_counter()
+        lazy_tensors = lm.send_cpu_data_to_device(tensors, device)
+        elapsed.append(time.perf_counter() - start)
+        del lazy_tensors
+    best = min(elapsed)
+    return best, count * numel * 4 / best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--counts", type=int, nargs="+", default=[1, 16, 256, 1024])
+    parser.add_argument(
+        "--sizes", type=int, nargs="+", default=[1 << 10, 1 << 16, 1 << 20, 1 << 24]
+    )
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--max-bytes", type=int, default=1 << 30, help="Skip larger batches")
+    args = parser.parse_args()
+
+    device = lm.lazy_device()
+    print(f"{'count':>8} {'bytes':>10} {'latency (ms)':>14} {'throughput (GB/s)':>18}")
+    for count in args.counts:
+        for nbytes in args.sizes:
+            if count * nbytes > args.max_bytes:
+                continue
+            latency, throughput = bench(count, nbytes, device, args.repeat)
+            print(f"{count:>8} {nbytes:>10} {latency * 1e3:>14.3f} {throughput / 1e9:>18.3f}")
+
+
+if __name__ == "__main__":
+    main()
@@ -1,8 +1,11 @@
 # Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 # SPDX-License-Identifier: Apache-2.0
 
-"""Test ZeRO-1 implementation using FSDP interface."""
+"""Test ZeRO implementation using FSDP interface."""
+import os
+
 import pytest
+import raf
 
 import torch
 import torch.nn as nn
@@ -12,10 +15,16 @@ from raf.testing import with_seed, get_dist_comm_info, skip_dist_test
 from raf import distributed as dist
 
 import ratex
+import ratex.core.lazy_model as rlm
 import ratex.lazy_tensor_core.core.lazy_model as lm
 from ratex.core.distributed.ratex_fully_sharded_data_parallel import RatexFullyShardedDataParallel
 from ratex.optimizer import SGD, Adam
-from ratex.testing import check
+from ratex.testing import (
+    check,
+    dryrun_dumped_ir_file,
+    with_mock_distributed_info,
+    with_temp_cache,
+)
 import numpy as np
 
 
@@ -41,6 +50,7 @@ def train(
     optimizer_config,
     image_datasets,
     fsdp=False,
+    sharding_stage=1,
     num_epochs=10,
     dtype=torch.float32,
     seed=None,
@@ -59,7 +69,9 @@ def train(
     model = ratex.jit.script(model)
     model = model.to(device, dtype=dtype)
     if fsdp:
-        model = RatexFullyShardedDataParallel(model, optimizer, optimizer_config)
+        model = RatexFullyShardedDataParallel(
+            model, optimizer, optimizer_config, sharding_stage=sharding_stage
+        )
         optimizer = model
         model.train()
     else:
@@ -94,8 +106,9 @@ def train(
 @pytest.mark.parametrize(
     "optimizer", [(SGD, {"lr": 0.001, "momentum": 0.1}), (Adam, {"lr": 0.001})]
 )
+@pytest.mark.parametrize("sharding_stage", [1, 2, 3])
 def test_ratex_fully_sharded_data_parallelism_zero1(
-    input_shape, num_classes, optimizer, tolerance=1e-10, seed=0
+    input_shape, num_classes, optimizer, sharding_stage, tolerance=1e-10, seed=0
 ):
     data_transforms = {
         "train": transforms.Compose(
@@ -160,11 +173,75 @@ def test_ratex_fully_sharded_data_parallelism_zero1(
         optimizer[1],
         image_datasets,
         fsdp=True,
+        sharding_stage=sharding_stage,
         seed=seed,
     )
 
     check(no_zero1_loss, fsdp_zero1_loss, atol=tolerance)
 
 
+@with_temp_cache
+@dryrun_dumped_ir_file
+@with_mock_distributed_info(world_size=2, rank=1)
+@pytest.mark.parametrize("sharding_stage", [2, 3])
+def test_compile_fsdp(sharding_stage):
+    """A step of the sharding stages 2 and 3 is a single graph, which holds the collectives of
+    every bucket."""
+    model = SingleLayerLogistics(input_shape=28, num_classes=12).to("lazy")
+    # Each parameter is a bucket of its own.
+    model = RatexFullyShardedDataParallel(
+        model, SGD, {"lr": 0.001}, sharding_stage=sharding_stage, bucket_size_mb=1e-4
+    )
+    num_buckets = len(model.buckets)
+    assert num_buckets == 2
+    inputs = torch.rand(1, 1, 28, 28).to("lazy")
+    model.zero_grad()
+    loss = model(inputs).sum()
+    loss.backward()
+    model.step()
+    lm.mark_step()
+
+    with open(os.environ["RATEX_SAVE_IR_FILE"]) as module_file:
+        module = raf.ir.serialization.LoadJSON(module_file.read())
+    text = raf.ir.AsText(module)
+    # The stage 3 gathers the parameters for the forward pass, and the stage 2 after the update.
+    # The backward pass of the stage 3 does not need them, as the inputs do not require gradients.
+    assert text.count("_reduce_scatter") == num_buckets
+    assert text.count("_allgather") == num_buckets
+
+
+@with_temp_cache
+@dryrun_dumped_ir_file
+@with_mock_distributed_info(world_size=2, rank=1)
+def test_fsdp_stage3_memory():
+    """The sharding stage 3 only keeps the full parameters of the layers in use, so the peak
+    memory of its step is below the one of the stage 2."""
+
+    def step_peak_bytes(sharding_stage):
+        layers = []
+        for _ in range(4):
+            layers += [nn.Linear(512, 512), nn.ReLU()]
+        model = nn.Sequential(*layers).to("lazy")
+        model = RatexFullyShardedDataParallel(
+            model, SGD, {"lr": 0.001}, sharding_stage=sharding_stage
+        )
+        assert len(model.units) == (4 if sharding_stage == 3 else 0)
+        lm.mark_step()
+        known = {executable["id"] for executable in rlm.get_executable_memory_info()}
+        inputs = torch.rand(8, 512).to("lazy")
+        model.zero_grad()
+        loss = model(inputs).sum()
+        loss.backward()
+        model.step()
+        lm.mark_step()
+        return max(
+            executable["peak_bytes"]
+            for executable in rlm.get_executable_memory_info()
+            if executable["id"] not in known
+        )
+
+    assert step_peak_bytes(3) < step_peak_bytes(2)
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
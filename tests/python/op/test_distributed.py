@@ -3,6 +3,8 @@
 
 import sys
 import os
+from unittest.mock import patch
+
 import pytest
 import numpy as np
 import torch
@@ -11,8 +13,16 @@ import raf
 import ratex
 from raf import distributed as dist
 from raf.testing import get_dist_comm_info, skip_dist_test
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.debug.metrics as metrics
 from ratex.lazy_tensor_core.core.lazy_model import lazy_device
-from ratex.core.lazy_model import all_gather, all_reduce, reduce_scatter
+from ratex.core.lazy_model import (
+    all_gather,
+    all_reduce,
+    all_to_all,
+    collective_permute,
+    reduce_scatter,
+)
 from ratex.testing import (
     check,
     with_enable_param_aliasing,
@@ -168,6 +178,76 @@ def test_reduce_scatter_with_rank_list(computation, rank_list, dtype):
                 check(ret, odd_out)
 
 
+@pytest.mark.skipif(skip_dist_test(min_rank_num=2), reason=SKIP_REASON)
+@pytest.mark.parametrize("dtype", ["float32", "float16"])
+@pytest.mark.parametrize("split_dim,concat_dim", [(0, 0), (1, 0), (0, 2)])
+def test_all_to_all(dtype, split_dim, concat_dim):
+    """Test of tracing and lowering all_to_all op."""
+    total_rank, rank, local_rank = get_dist_comm_info()
+    shape = [2, 3, 2]
+    shape[split_dim] *= total_rank
+    n_x = np.arange(np.prod(shape)).reshape(shape).astype(dtype)
+    n_xs = [n_x + r * 100 for r in range(total_rank)]
+    x = torch.from_numpy(n_xs[rank]).to(lazy_device(rank))
+    y = all_to_all(x, split_dim, concat_dim)
+    blocks = [np.split(n_x, total_rank, axis=split_dim)[rank] for n_x in n_xs]
+    check(y, np.concatenate(blocks, axis=concat_dim))
+
+
+@pytest.mark.skipif(skip_dist_test(min_rank_num=4, require_exact_rank=True), reason=SKIP_REASON)
+@pytest.mark.parametrize("dtype", ["float32", "float16"])
+def test_all_to_all_with_subcomm(dtype):
+    """Testing all_to_all with replica groups."""
+    _, rank, local_rank = get_dist_comm_info()
+    groups = [[0, 2], [1, 3]]
+    n_xs = [np.arange(8).reshape(4, 2).astype(dtype) + r * 100 for r in range(4)]
+    x = torch.from_numpy(n_xs[rank]).to(lazy_device(rank))
+    y = all_to_all(x, 0, 1, groups=groups)
+    group = groups[rank % 2]
+    index = group.index(rank)
+    check(y, np.concatenate([n_xs[r][index * 2 : index * 2 + 2] for r in group], axis=1))
+
+
+@pytest.mark.skipif(skip_dist_test(min_rank_num=2), reason=SKIP_REASON)
+@pytest.mark.parametrize("dtype", ["float32", "float16"])
+@pytest.mark.parametrize("ring", [True, False])
+def test_collective_permute(dtype, ring):
+    """Test of tracing and lowering collective_permute op. Without the ring, the last rank only
+    receives and the first rank receives zeros."""
+    total_rank, rank, local_rank = get_dist_comm_info()
+    n_ones = np.ones(shape=(4, 4), dtype=dtype)
+    x = torch.from_numpy(n_ones * (rank + 1)).to(lazy_device(rank))
+    pairs = [[r, (r + 1) % total_rank] for r in range(total_rank if ring else total_rank - 1)]
+    y = collective_permute(x, pairs)
+    source = (rank - 1) % total_rank
+    check(y, n_ones * (source + 1) if ring or rank > 0 else n_ones * 0)
+
+
+@pytest.mark.skipif(skip_dist_test(min_rank_num=2), reason=SKIP_REASON)
+def test_schedule_collectives():
+    """The all-reduce of a1 is scheduled before the independent matmul, and the order is still
+    the same once the VM compiler optimizes the graph."""
+    total_rank, rank, local_rank = get_dist_comm_info()
+    device = lazy_device(rank)
+    n_x = np.ones(shape=(64, 64), dtype="float32")
+    x = torch.from_numpy(n_x).to(device)
+    w = torch.from_numpy(n_x * 2).to(device)
+    lm.mark_step()
+
+    verified = metrics.counter_value("RAFCollectiveScheduleVerified") or 0
+    with patch.dict(
+        os.environ,
+        {"RATEX_SCHEDULE_COLLECTIVES": "true", "RATEX_VERIFY_COLLECTIVE_SCHEDULE": "true"},
+    ):
+        a1 = torch.relu(x)
+        a2 = torch.matmul(w, w)
+        y = all_reduce("sum", a1) + a2
+        lm.mark_step()
+    check(y, n_x * total_rank + n_x * 4 * 64)
+    assert (metrics.counter_value("RAFCollectiveScheduleVerified") or 0) == verified + 1
+    assert (metrics.counter_value("RAFCollectiveScheduleLost") or 0) == 0
+
+
 if __name__ == "__main__":
     if os.environ.get("RAF_FILE_STORE_PATH", None):
         dist.set_default_communicator("void")
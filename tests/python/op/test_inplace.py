@@ -1,11 +1,16 @@
 # Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
 # SPDX-License-Identifier: Apache-2.0
 
+import os
+from unittest.mock import patch
+
 import pytest
 import torch
 import torch.nn as nn
 import raf
 import numpy as np
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.debug.metrics as metrics
 from ratex.testing import compile_model, run_step, with_enable_param_aliasing
 
 
@@ -58,5 +63,45 @@ def test_mul_out():
     torch.testing.assert_close(out_t.to("cpu").numpy(), x_np * 2.0)
 
 
+@pytest.mark.parametrize("enable_aliasing", [True, False])
+def test_donation(enable_aliasing):
+    def get_counter(name):
+        return metrics.counter_value(name) or 0
+
+    with patch.dict(os.environ, {"ENABLE_PARAM_ALIASING": str(enable_aliasing).lower()}):
+        x = torch.ones(4, 4).to("lazy")
+        y = x * 2.0
+        lm.mark_step()
+
+        donated = get_counter("InputOutputDonatedBytes")
+        copied = get_counter("InputOutputCopiedBytes")
+        x.add_(1.0)
+        y.add_(x)
+        lm.mark_step()
+
+    # Both x and y are updated in-place and no other tensor refers to their old values.
+    nbytes = 2 * 4 * 4 * 4
+    if enable_aliasing:
+        assert get_counter("InputOutputDonatedBytes") - donated == nbytes
+        assert get_counter("InputOutputCopiedBytes") == copied
+    else:
+        assert get_counter("InputOutputCopiedBytes") - copied == nbytes
+    torch.testing.assert_close(x.to("cpu"), torch.full((4, 4), 2.0))
+    torch.testing.assert_close(y.to("cpu"), torch.full((4, 4), 4.0))
+
+
+@with_enable_param_aliasing
+def test_fetch_updated_tensor_twice():
+    # Fetching a tensor does not replace its IR graph with device data, so the graph must not
+    # donate the buffer it still reads.
+    a = torch.zeros(4, 4).to("lazy")
+    lm.mark_step()
+    a += 0.4
+    torch.testing.assert_close(a.to("cpu"), torch.full((4, 4), 0.4))
+    torch.testing.assert_close(a.to("cpu"), torch.full((4, 4), 0.4))
+    lm.mark_step()
+    torch.testing.assert_close(a.to("cpu"), torch.full((4, 4), 0.4))
+
+
 if __name__ == "__main__":
     pytest.main([__file__])
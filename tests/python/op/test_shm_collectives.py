@@ -0,0 +1,193 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import os
+import subprocess
+import sys
+import time
+
+import pytest
+
+WORKER = """
+import torch
+import ratex
+from ratex.core import shm_collectives
+from ratex.core.lazy_model import all_gather, all_reduce, all_to_all, collective_permute
+from ratex.core.lazy_model import reduce_scatter
+from ratex.lazy_tensor_core.core.lazy_model import lazy_device
+
+rank, size = shm_collectives.get_rank(), shm_collectives.get_world_size()
+device = lazy_device()
+
+# Large enough to be staged in several chunks.
+x = torch.arange(1 << 20).remainder(64).to(torch.{dtype}) + rank
+y = all_reduce("sum", x.to(device), scale=1.0 / size).to("cpu")
+expected = (torch.arange(1 << 20).remainder(64) * size + size * (size - 1) // 2) / size
+torch.testing.assert_close(y, expected.to(torch.{dtype}))
+
+grads = [torch.full((3, 5), float(rank + 1)).to(device) for _ in range(2)]
+all_reduce("max", grads)
+for grad in grads:
+    torch.testing.assert_close(grad.to("cpu"), torch.full((3, 5), float(size)))
+
+x = torch.full((2, 3), float(rank))
+y = all_gather(x.to(device), dim=1).to("cpu")
+torch.testing.assert_close(y, torch.arange(size).float().repeat_interleave(3).repeat(2, 1))
+
+x = torch.arange(size * 4, dtype=torch.float32).reshape(size * 2, 2) + rank
+y = reduce_scatter(x.to(device), "sum").to("cpu")
+expected = (torch.arange(size * 4).reshape(size * 2, 2) * size + size * (size - 1) // 2)
+torch.testing.assert_close(y, expected[rank * 2 : rank * 2 + 2].float())
+
+x = torch.full((4,), float(rank))
+y = shm_collectives.broadcast(x, root=size - 1)
+torch.testing.assert_close(y, torch.full((4,), float(size - 1)))
+
+x = torch.arange(size * 3).reshape(size, 3) + rank * 100
+y = shm_collectives.all_to_all(x, split_dim=0, concat_dim=0)
+expected = torch.stack([torch.arange(3) + rank * 3 + r * 100 for r in range(size)])
+torch.testing.assert_close(y, expected)
+
+x = torch.arange(2 * size * 3).reshape(2, size * 3) + rank * 100
+y = all_to_all(x.to(device), split_dimension=1, concat_dimension=0).to("cpu")
+expected = torch.cat([x[:, rank * 3 : rank * 3 + 3] - rank * 100 + r * 100 for r in range(size)])
+torch.testing.assert_close(y, expected)
+
+x = torch.full((3, 2), float(rank + 1))
+y = collective_permute(x.to(device), [[r, (r + 1) % size] for r in range(size)]).to("cpu")
+torch.testing.assert_close(y, torch.full((3, 2), float((rank - 1) % size + 1)))
+# The last rank only sends, so the first one receives zeros.
+y = collective_permute(x.to(device), [[r, r + 1] for r in range(size - 1)]).to("cpu")
+torch.testing.assert_close(y, torch.full((3, 2), float(rank if rank > 0 else 0)))
+
+# The sub-groups use their own segments.
+groups = [list(range(0, size, 2)), list(range(1, size, 2))]
+y = all_reduce("sum", torch.ones(4).to(device), groups=groups).to("cpu")
+torch.testing.assert_close(y, torch.full((4,), float(len(groups[rank % 2]))))
+"""
+
+
+GRADIENTS_WORKER = """
+import torch
+import ratex
+import ratex.lazy_tensor_core.debug.metrics as metrics
+from ratex.core import shm_collectives
+from ratex.core.lazy_model import reduce_gradients
+from ratex.lazy_tensor_core.core.lazy_model import lazy_device
+
+rank, size = shm_collectives.get_rank(), shm_collectives.get_world_size()
+device = lazy_device()
+shapes = [(64, 64), (64,), (32, 64), (32,), (1024, 256), (8,)]
+params = [torch.nn.Parameter(torch.zeros(shape).to(device)) for shape in shapes]
+params.append(torch.nn.Parameter(torch.zeros(16, dtype=torch.float64).to(device)))
+for index, param in enumerate(params):
+    param.grad = torch.full(param.shape, float(rank + index), dtype=param.dtype).to(device)
+optimizer = torch.optim.SGD(params, lr=0.1)
+reduce_gradients(optimizer, bucket_size_mb=0.03)
+for index, param in enumerate(params):
+    expected = torch.full(param.shape, index + (size - 1) / 2, dtype=param.dtype)
+    torch.testing.assert_close(param.grad.to("cpu"), expected)
+# The float32 gradients before the large one share a bucket, while the large one, the float32 one
+# after it and the float64 one get their own.
+assert metrics.counter_value("ReduceGradientsCollectives") == 4
+"""
+
+
+FSDP_WORKER = """
+import torch
+import ratex
+from ratex.core import shm_collectives
+from ratex.core.distributed.ratex_fully_sharded_data_parallel import RatexFullyShardedDataParallel
+from ratex.lazy_tensor_core.core.lazy_model import lazy_device, mark_step
+
+rank, size = shm_collectives.get_rank(), shm_collectives.get_world_size()
+device = lazy_device()
+
+
+def train(sharding_stage):
+    torch.manual_seed(0)
+    # The rows of the layers are not divisible by the number of ranks, so the shards are padded.
+    model = torch.nn.Sequential(torch.nn.Linear(8, 5), torch.nn.ReLU(), torch.nn.Linear(5, 3))
+    model = model.to(device)
+    if sharding_stage:
+        model = RatexFullyShardedDataParallel(
+            model, torch.optim.SGD, {{"lr": 0.1}}, sharding_stage, bucket_size_mb=1e-4
+        )
+        optimizer = model
+    else:
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.1)
+    for step in range(3):
+        # The reference runs the batches of all the ranks, which average their gradients.
+        inputs = torch.arange(size * 4 * 8).float().reshape(size, 4, 8).mul(0.01) + step
+        inputs = inputs[rank : rank + 1] if sharding_stage else inputs
+        optimizer.zero_grad()
+        loss = model(inputs.reshape(-1, 8).to(device)).sum() / inputs.size(0)
+        loss.backward()
+        optimizer.step()
+        mark_step()
+    if sharding_stage == 3:
+        model.gather_parameters()
+    return [param.to("cpu") for param in model.parameters()]
+
+
+expected = train(0)
+for stage in [{stage}]:
+    for param, reference in zip(train(stage), expected):
+        torch.testing.assert_close(param, reference)
+"""
+
+
+def worker_env(rank, size, name, timeout=120):
+    return dict(
+        os.environ,
+        RATEX_COLLECTIVE_BACKEND="shm",
+        RATEX_SHM_NAME="ratex_test_{}_{}".format(os.getpid(), name),
+        RATEX_SHM_RANK=str(rank),
+        RATEX_SHM_WORLD_SIZE=str(size),
+        RATEX_SHM_SLOT_SIZE="1",
+        RATEX_SHM_TIMEOUT=str(timeout),
+    )
+
+
+def run_workers(script, size, name):
+    workers = []
+    for rank in range(size):
+        env = worker_env(rank, size, name)
+        workers.append(subprocess.Popen([sys.executable, "-c", script], env=env))
+    assert all(worker.wait() == 0 for worker in workers)
+
+
+@pytest.mark.parametrize("dtype", ["float32", "bfloat16", "float16"])
+def test_shm_collectives(dtype):
+    run_workers(WORKER.format(dtype=dtype), 4, dtype)
+
+
+def test_reduce_gradients_buckets():
+    run_workers(GRADIENTS_WORKER, 2, "gradients")
+
+
+@pytest.mark.parametrize("stage", [1, 2, 3])
+def test_fully_sharded_data_parallel(stage):
+    run_workers(FSDP_WORKER.format(stage=stage), 2, "fsdp_{}".format(stage))
+
+
+def test_stale_segment():
+    script = """
+import torch
+from ratex.core import shm_collectives
+
+x = shm_collectives.all_reduce(torch.ones(4), "sum")
+torch.testing.assert_close(x, torch.full((4,), 2.0))
+"""
+    # A rank 0 whose peer never comes times out and leaves its segment behind, as a crashed run.
+    stale = subprocess.run([sys.executable, "-c", script], env=worker_env(0, 2, "stale", 1))
+    assert stale.returncode != 0
+    # The next run of the same name does not attach to it, even if rank 1 starts first.
+    workers = [subprocess.Popen([sys.executable, "-c", script], env=worker_env(1, 2, "stale"))]
+    time.sleep(1)
+    workers.append(subprocess.Popen([sys.executable, "-c", script], env=worker_env(0, 2, "stale")))
+    assert all(worker.wait(timeout=60) == 0 for worker in workers)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
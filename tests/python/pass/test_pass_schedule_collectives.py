@@ -0,0 +1,77 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import pytest
+
+from ratex._lib import raf
+import tvm
+from tvm import relay
+from raf.ir import ScopeBuilder
+
+_APIS = raf._lib._get_apis()
+ScheduleCollectives = _APIS.get("raf.pass_.ScheduleCollectives", None)
+
+
+def test_overlap():
+    relu_op = raf._ffi.op.GetOp("raf.op.relu")
+    mul_op = raf._ffi.op.GetOp("raf.op.multiply")
+    add_op = raf._ffi.op.GetOp("raf.op.add")
+    allreduce_op = raf._ffi.op.GetOp("raf.op._allreduce")
+    null = raf.ir.const(None)
+    reduce_sum = raf.ir.const("sum")
+
+    def get_mod(order):
+        data_1 = raf.ir.var("p1", shape=(16, 16))
+        data_2 = raf.ir.var("p2", shape=(16, 16))
+        bindings = {}
+        exprs = {
+            "a1": lambda: relay.Call(relu_op, [data_1]),
+            "a2": lambda: relay.Call(relu_op, [bindings["a1"]]),
+            "a3": lambda: relay.Call(mul_op, [data_2, data_2]),
+            "t1": lambda: relay.Tuple([bindings["a1"]]),
+            "r1": lambda: relay.Call(allreduce_op, [bindings["t1"], reduce_sum, null]),
+            "t2": lambda: relay.Tuple([bindings["a2"]]),
+            "r2": lambda: relay.Call(allreduce_op, [bindings["t2"], reduce_sum, null]),
+            "u1": lambda: relay.Call(add_op, [data_1, bindings["r1"], null, null]),
+            "u2": lambda: relay.Call(add_op, [bindings["a3"], bindings["r2"], null, null]),
+        }
+        sb = ScopeBuilder()
+        for name in order:
+            bindings[name] = sb.let(name, exprs[name]())
+        out = sb.let("out", relay.Tuple([bindings["u1"], bindings["u2"]]))
+        sb.ret(out)
+        func = relay.Function([data_1, data_2], sb.get())
+        return tvm.IRModule.from_expr(func)
+
+    # As traced, the gradients are all computed before they are reduced.
+    before = get_mod(["a1", "a2", "a3", "t1", "r1", "t2", "r2", "u1", "u2"])
+    # Each all-reduce is issued once its input is computed, the independent computation overlaps
+    # with the all-reduces, and their consumers come last.
+    expected = get_mod(["a1", "t1", "r1", "a2", "t2", "r2", "a3", "u1", "u2"])
+    mod = ScheduleCollectives()(before)
+    assert tvm.ir.structural_equal(mod["main"], expected["main"])
+
+
+def test_no_collective():
+    relu_op = raf._ffi.op.GetOp("raf.op.relu")
+    mul_op = raf._ffi.op.GetOp("raf.op.multiply")
+
+    def before():
+        data_1 = raf.ir.var("p1", shape=(16, 16))
+        data_2 = raf.ir.var("p2", shape=(16, 16))
+
+        sb = ScopeBuilder()
+        a_1 = sb.let("a1", relay.Call(relu_op, [data_1]))
+        a_2 = sb.let("a2", relay.Call(mul_op, [data_2, data_2]))
+        a_3 = sb.let("a3", relay.Call(mul_op, [a_1, a_2]))
+        sb.ret(a_3)
+        func = relay.Function([data_1, data_2], sb.get())
+        return tvm.IRModule.from_expr(func)
+
+    # The bindings keep their order.
+    mod = ScheduleCollectives()(before())
+    assert tvm.ir.structural_equal(mod["main"], before()["main"])
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
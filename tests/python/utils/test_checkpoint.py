@@ -0,0 +1,85 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import collections
+
+import pytest
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.utils.mmap_checkpoint as ckpt
+
+
+def make_state():
+    weight = torch.randn(64, 32)
+    return {
+        "model": collections.OrderedDict(
+            [
+                ("fc.weight", weight),
+                ("fc.bias", torch.randn(32).to(torch.bfloat16)),
+                ("steps", torch.tensor(7)),
+                ("mask", torch.rand(8, 8) > 0.5),
+                ("tied", weight),
+            ]
+        ),
+        "history": [torch.arange(10, dtype=torch.int32), 0.5],
+        "epoch": 3,
+    }
+
+
+def test_save_load(tmp_path):
+    path = str(tmp_path / "model.ckpt")
+    state = make_state()
+    device = lm.lazy_device()
+    lazy_state = lm.send_cpu_data_to_device(state, device)
+    # Pending computations are saved too.
+    lazy_state["model"]["fc.weight"] = lazy_state["model"]["fc.weight"] * 2
+    lazy_state["model"]["tied"] = lazy_state["model"]["fc.weight"]
+    ckpt.save(lazy_state, path)
+
+    loaded = ckpt.load(path)
+    assert loaded["epoch"] == 3
+    assert list(loaded["model"]) == list(state["model"])
+    torch.testing.assert_close(loaded["model"]["fc.weight"], state["model"]["fc.weight"] * 2)
+    assert loaded["model"]["tied"] is loaded["model"]["fc.weight"]
+    for key in ("fc.bias", "steps", "mask"):
+        torch.testing.assert_close(loaded["model"][key], state["model"][key])
+    torch.testing.assert_close(loaded["history"][0], state["history"][0])
+    assert loaded["history"][1] == 0.5
+
+    loaded_lazy = ckpt.load(path, device=device)
+    assert lm.is_lazy_tensor(loaded_lazy["model"]["fc.bias"])
+    torch.testing.assert_close(loaded_lazy["model"]["fc.bias"].cpu(), state["model"]["fc.bias"])
+
+
+def test_partial_load(tmp_path):
+    path = str(tmp_path / "model.ckpt")
+    state = make_state()
+    ckpt.save(state, path)
+
+    reader = ckpt.CheckpointReader(path)
+    assert "model.fc.bias" in reader.names()
+    assert "model.tied" not in reader.names()
+    loaded = ckpt.load(path, names=["model.fc.bias"], device=lm.lazy_device())
+    assert list(loaded) == ["model.fc.bias"]
+    torch.testing.assert_close(loaded["model.fc.bias"].cpu(), state["model"]["fc.bias"])
+
+
+def test_sharded(tmp_path):
+    path = str(tmp_path / "optim.ckpt")
+    shards = [{"exp_avg": torch.full((4,), float(rank))} for rank in range(2)]
+    for rank, shard in enumerate(shards):
+        ckpt.save(shard, path, rank=rank)
+    for rank, shard in enumerate(shards):
+        torch.testing.assert_close(ckpt.load(path, rank=rank)["exp_avg"], shard["exp_avg"])
+
+
+def test_invalid_file(tmp_path):
+    path = tmp_path / "invalid.ckpt"
+    path.write_bytes(b"\0" * 64)
+    with pytest.raises(ValueError):
+        ckpt.CheckpointReader(str(path))
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
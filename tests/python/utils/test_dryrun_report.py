@@ -0,0 +1,40 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import json
+import os
+
+import pytest
+import torch.optim as optim
+
+from ratex.testing import TorchLeNet, fake_image_dataset, train
+from ratex.testing import dryrun_dumped_ir_file
+
+
+@dryrun_dumped_ir_file
+def test_dryrun_report():
+    batch_size = 1
+    num_epochs = 2
+    dataset = fake_image_dataset(batch_size, 1, 28, 10)
+    model = TorchLeNet()
+
+    train("lazy", model, dataset, optimizer=optim.SGD, batch_size=batch_size, num_epochs=num_epochs)
+
+    report_path = os.environ["RATEX_DRY_RUN_REPORT"]
+    with open(report_path + ".jsonl") as report_file:
+        steps = [json.loads(line) for line in report_file]
+    assert len(steps) >= num_epochs
+    # The executions of the process are numbered consecutively.
+    first = steps[0]["execution"]
+    assert [step["execution"] for step in steps] == list(range(first, first + len(steps)))
+    train_step = max(steps, key=lambda step: step["flops"])
+    assert "raf.op.conv2d" in train_step["op_counts"]
+    assert train_step["bytes_moved"] > 0
+    assert train_step["peak_bytes"] >= train_step["param_bytes"] > 0
+    # All steps are recorded in both formats.
+    with open(report_path + ".txt") as report_file:
+        assert report_file.read().count("FLOPs:") == len(steps)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
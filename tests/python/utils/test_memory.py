@@ -0,0 +1,114 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import os
+from unittest.mock import patch
+
+import pytest
+import torch
+import torch.optim as optim
+
+import ratex.core.lazy_model as rlm
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.debug.metrics as metrics
+from ratex.testing import TorchLeNet, fake_image_dataset, train, with_enable_param_aliasing
+
+
+def test_memory_info():
+    batch_size = 1
+    dataset = fake_image_dataset(batch_size, 1, 28, 10)
+    model = TorchLeNet()
+
+    train("lazy", model, dataset, optimizer=optim.SGD, batch_size=batch_size, num_epochs=1)
+
+    info = lm.get_memory_info("")
+    assert info["kb_total"] > 0
+    assert 0 <= info["kb_free"] <= info["kb_total"]
+    assert info["kb_peak"] > 0
+
+    executables = rlm.get_executable_memory_info()
+    assert executables
+    for executable in executables:
+        assert executable["peak_bytes"] == (
+            executable["param_bytes"] + executable["constant_bytes"] + executable["workspace_bytes"]
+        )
+        assert executable["peak_bytes"] >= executable["param_bytes"] > 0
+
+
+def test_constant_pool():
+    hits = metrics.counter_value("ConstantPoolHit") or 0
+    x = torch.ones(1000).to("lazy")
+    # Both graphs embed the same arange constant, which is uploaded once.
+    y = x * torch.arange(1000, device="lazy")
+    lm.mark_step()
+    z = x + torch.arange(1000, device="lazy")
+    lm.mark_step()
+    assert (metrics.counter_value("ConstantPoolHit") or 0) - hits >= 1
+    torch.testing.assert_close(y.to("cpu"), torch.arange(1000, dtype=torch.float32))
+    torch.testing.assert_close(z.to("cpu"), torch.arange(1000, dtype=torch.float32) + 1)
+
+
+@with_enable_param_aliasing
+def test_inplace_update_memory():
+    known = {executable["id"] for executable in rlm.get_executable_memory_info()}
+    x = torch.zeros(1024, 1024).to("lazy")
+    w = torch.ones(1024, 1024).to("lazy")
+    lm.mark_step()
+    x.add_(w)
+    lm.mark_step()
+    torch.testing.assert_close(x.to("cpu"), torch.ones(1024, 1024))
+
+    # The update is written to the buffer of x, so that it does not grow the footprint.
+    executables = rlm.get_executable_memory_info()
+    update = max(
+        (executable for executable in executables if executable["id"] not in known),
+        key=lambda executable: executable["param_bytes"],
+    )
+    assert update["param_bytes"] == 2 * x.nelement() * x.element_size()
+    assert update["workspace_bytes"] < x.nelement() * x.element_size()
+
+
+@patch.dict(os.environ, {"RATEX_MEMORY_BUDGET": "auto", "RATEX_DEVICE_MEMORY_CAPACITY": "65536"})
+def test_auto_memory_budget():
+    batch_size = 1
+    dataset = fake_image_dataset(batch_size, 1, 28, 10)
+    model = TorchLeNet()
+
+    train("lazy", model, dataset, optimizer=optim.SGD, batch_size=batch_size, num_epochs=1)
+
+    # LeNet fits the device memory so no rematerialization is applied.
+    executables = rlm.get_executable_memory_info()
+    assert executables
+    for executable in executables:
+        assert executable["memory_budget"] == 0
+        assert executable["recompute_ops"] == 0
+
+
+@patch.dict(os.environ, {"RATEX_MEMORY_BUDGET": "auto", "RATEX_DEVICE_MEMORY_CAPACITY": "2"})
+def test_auto_memory_budget_below_params():
+    known = {executable["id"] for executable in rlm.get_executable_memory_info()}
+    x = torch.ones(1024, 1024).to("lazy")
+    w = torch.full((1024, 1024), 2.0).to("lazy")
+    lm.mark_step()
+    y = torch.relu(torch.matmul(x, w)) + x
+    lm.mark_step()
+    torch.testing.assert_close(y.to("cpu"), torch.full((1024, 1024), 2049.0))
+
+    # The 8 MBs of parameters exceed the 2 MBs capacity, so the tightest budget is used.
+    executables = rlm.get_executable_memory_info()
+    for executable in executables:
+        if executable["id"] not in known and executable["param_bytes"] > 0:
+            assert executable["memory_budget"] == 2
+
+
+@pytest.mark.parametrize("memory_budget", ["-1", "1GB", ""])
+def test_invalid_memory_budget(memory_budget):
+    x = torch.ones(16, 16).to("lazy")
+    y = x * 3
+    with patch.dict(os.environ, {"RATEX_MEMORY_BUDGET": memory_budget}):
+        with pytest.raises(RuntimeError, match="RATEX_MEMORY_BUDGET"):
+            lm.mark_step()
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -0,0 +1,46 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import threading
+
+import pytest
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+
+
+def test_prefetch_to_host():
+    x = torch.zeros(4, 4).to("lazy")
+    w = torch.ones(4, 4).to("lazy")
+    futures = []
+    for _ in range(3):
+        x.add_(w)
+        futures.append(lm.prefetch_to_host(x.sum()))
+        lm.mark_step()
+    scalar, tensors = futures[-1], lm.prefetch_to_host([x, w])
+    assert [future.result().item() for future in futures] == [16.0, 32.0, 48.0]
+    assert scalar.done()
+    torch.testing.assert_close(tensors.result(), [torch.full((4, 4), 3.0), torch.ones(4, 4)])
+
+
+def test_prefetch_to_host_concurrent():
+    # More fetches in flight than threads in the pools, from several Python threads. The fetches
+    # are continuations of the executions, so none of them waits on a pool thread.
+    x = torch.arange(16, dtype=torch.float32).reshape(4, 4).to("lazy")
+    results = {}
+
+    def prefetch(index):
+        futures = [lm.prefetch_to_host((x * (index + step)).sum()) for step in range(16)]
+        results[index] = [future.result().item() for future in futures]
+
+    threads = [threading.Thread(target=prefetch, args=(i,)) for i in range(8)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    for index in range(8):
+        assert results[index] == [120.0 * (index + step) for step in range(16)]
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -0,0 +1,25 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import pytest
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+
+
+def test_tensor_ready_events():
+    # Each step consumes the output of the previous one while it may still be executing, and the
+    # outputs of all the steps are read once the last one is scheduled.
+    w = torch.full((64, 64), 1.0 / 64).to("lazy")
+    x = torch.ones(64, 64).to("lazy")
+    outputs = []
+    for step in range(4):
+        x = x @ w + 1
+        lm.mark_step()
+        outputs.append(x)
+    for step, output in enumerate(outputs):
+        torch.testing.assert_close(output.to("cpu"), torch.full((64, 64), step + 2.0))
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
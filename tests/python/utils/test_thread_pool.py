@@ -0,0 +1,112 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import os
+import subprocess
+import sys
+
+import pytest
+import torch
+
+import _RATEXC
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.debug.metrics as metrics
+
+
+def test_blocked_io_pool():
+    # Four times more closures than threads in the IO pool, each of which blocks until the one
+    # scheduled after it ran, so the pool must run the queued closures on escape threads, as many
+    # as the blocked closures.
+    script = """
+import threading
+import ratex
+import _RATEXC
+import ratex.lazy_tensor_core.debug.metrics as metrics
+
+for priority in ["default", "background"]:
+    _RATEXC._ltc_set_closure_priority(priority)
+    events = [threading.Event() for _ in range(8)]
+
+    def closure(index):
+        if index + 1 < len(events):
+            # The wait is declared as blocking, so that the closures queued behind it can run.
+            assert _RATEXC._ltc_run_blocking(lambda: events[index + 1].wait(timeout=60))
+        events[index].set()
+
+    for index in range(len(events)):
+        _RATEXC._ltc_schedule_io_closure(lambda index=index: closure(index))
+    assert events[0].wait(timeout=60)
+assert metrics.counter_value("IoThreadPoolEscapeThreads") > 0
+"""
+    env_vars = dict(
+        os.environ,
+        LTC_IO_THREAD_POOL_SIZE="2",
+        LTC_THREAD_POOL_STALL_MS="20",
+        LTC_THREAD_POOL_MAX_ESCAPES="8",
+    )
+    subprocess.run([sys.executable, "-c", script], env=env_vars, check=True, timeout=120)
+
+
+def test_background_limit():
+    # The background closures run longer than the stall interval, which must not let the queued
+    # ones exceed the limit of the class, half of the IO pool.
+    script = """
+import threading
+import time
+import ratex
+import _RATEXC
+
+lock = threading.Lock()
+running = [0, 0]
+done = threading.Semaphore(0)
+
+def closure():
+    with lock:
+        running[0] += 1
+        running[1] = max(running[1], running[0])
+    time.sleep(0.2)
+    with lock:
+        running[0] -= 1
+    done.release()
+
+_RATEXC._ltc_set_closure_priority("background")
+for _ in range(8):
+    _RATEXC._ltc_schedule_io_closure(closure)
+for _ in range(8):
+    assert done.acquire(timeout=60)
+assert running[1] == 2, running[1]
+"""
+    env_vars = dict(os.environ, LTC_IO_THREAD_POOL_SIZE="4", LTC_THREAD_POOL_STALL_MS="20")
+    subprocess.run([sys.executable, "-c", script], env=env_vars, check=True, timeout=120)
+
+
+def test_closure_priority():
+    def latency_samples(name):
+        if name not in metrics.metric_names():
+            return 0
+        return metrics.metric_data(name)[0]
+
+    # Tensors over 64KB are transferred in parallel on the IO threads.
+    tensors = [torch.randn(128, 1024) for _ in range(4)]
+    background = latency_samples("IoThreadPoolTaskLatency:background")
+    with lm.closure_priority("background"):
+        lazy_tensors = lm.send_cpu_data_to_device(tensors, lm.lazy_device())
+        with lm.closure_priority("transfer"):
+            pass
+        # The previous priority is restored when a context exits.
+        assert _RATEXC._ltc_set_closure_priority("background") == "background"
+    assert latency_samples("IoThreadPoolTaskLatency:background") > background
+    assert _RATEXC._ltc_set_closure_priority("default") == "default"
+
+    # The executions of the synced graphs and the prefetches are prioritized.
+    execution = latency_samples("IoThreadPoolTaskLatency:execution")
+    transfer = latency_samples("IoThreadPoolTaskLatency:transfer")
+    outputs = lm.prefetch_to_host([t * 2 for t in lazy_tensors]).result()
+    assert latency_samples("IoThreadPoolTaskLatency:execution") > execution
+    assert latency_samples("IoThreadPoolTaskLatency:transfer") > transfer
+    for output, tensor in zip(outputs, tensors):
+        torch.testing.assert_close(output, tensor * 2)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
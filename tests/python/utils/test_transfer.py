@@ -0,0 +1,191 @@
+# Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+# SPDX-License-Identifier: Apache-2.0
+
+import os
+import subprocess
+import sys
+
+import pytest
+import torch
+
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.debug.metrics as metrics
+
+
+def get_counter(name):
+    return metrics.counter_value(name) or 0
+
+
+def on_host():
+    return lm.lazy_device_hw(lm.lazy_device()) == "CPU"
+
+
+@pytest.mark.skipif(on_host(), reason="Tensors are not staged when the device is the host")
+def test_host_staging_pool():
+    batches = [torch.randn(16, 32) for _ in range(3)]
+    # Warm up the pool with the size class of the batches.
+    batches[0].to("lazy")
+
+    hits = get_counter("HostStagingPoolHit")
+    reused = get_counter("HostStagingPoolBytesReused")
+    for batch in batches:
+        x_lazy = batch.to("lazy")
+        torch.testing.assert_close(x_lazy.to("cpu"), batch)
+    assert get_counter("HostStagingPoolHit") - hits >= len(batches)
+    assert get_counter("HostStagingPoolBytesReused") - reused >= len(batches) * 16 * 32 * 4
+    assert metrics.metric_data("TransferToServerThroughput") is not None
+
+
+def test_batched_transfer():
+    # Small tensors share staging buffers, while the large ones are transferred on their own.
+    data = {
+        "small": [torch.randn(8, 8) for _ in range(64)],
+        "large": [torch.randn(512, 512) for _ in range(4)],
+        "int": torch.arange(1000, dtype=torch.int32),
+    }
+    groups = get_counter("TransferToServerGroups")
+    lazy_data = lm.send_cpu_data_to_device(data, lm.lazy_device())
+    assert get_counter("TransferToServerGroups") - groups < 64 + 4 + 1
+    for x, x_lazy in zip(data["small"] + data["large"], lazy_data["small"] + lazy_data["large"]):
+        torch.testing.assert_close(x_lazy.to("cpu"), x)
+    torch.testing.assert_close(lazy_data["int"].to("cpu"), data["int"])
+
+
+@pytest.mark.skipif(not on_host(), reason="Zero-copy transfers require the host as device")
+def test_zero_copy_transfer():
+    x = torch.randn(32, 32)
+    unstaged = get_counter("TransferToServerUnstaged")
+    x_lazy = x.to("lazy")
+    assert get_counter("TransferToServerUnstaged") - unstaged >= 1
+
+    zero_copy = get_counter("TransferFromServerZeroCopy")
+    x_cpu = x_lazy.to("cpu")
+    assert get_counter("TransferFromServerZeroCopy") - zero_copy >= 1
+    torch.testing.assert_close(x_cpu, x)
+
+    # The tensors do not share storage with the device buffer.
+    x_cpu.add_(1)
+    torch.testing.assert_close(x_lazy.to("cpu"), x)
+
+
+@pytest.mark.skipif(not on_host(), reason="Zero-copy transfers require the host as device")
+def test_zero_copy_device_data():
+    x = torch.ones(4, 4).to("lazy")
+    zero_copy = get_counter("TransferToServerZeroCopy")
+    # The scalar is uploaded by sharing the private tensor of the device data cache.
+    y = x * 1234.5
+    assert get_counter("TransferToServerZeroCopy") - zero_copy >= 1
+    torch.testing.assert_close(y.to("cpu"), torch.full((4, 4), 1234.5))
+
+
+@pytest.mark.skipif(on_host(), reason="Tensors are borrowed from the device buffers on host")
+def test_zero_copy_literal_to_tensor():
+    x = torch.randn(16, 16)
+    zero_copy = get_counter("LiteralToTensorZeroCopy")
+    torch.testing.assert_close(x.to("lazy").to("cpu"), x)
+    assert get_counter("LiteralToTensorZeroCopy") - zero_copy >= 1
+
+
+def test_bulk_fetch():
+    tensors = [torch.randn(16, 16) for _ in range(8)] + [torch.arange(100)]
+    lazy_tensors = lm.send_cpu_data_to_device(tensors, lm.lazy_device())
+    # Pending computations are fetched in bulk along with the device data.
+    lazy_tensors = [x * 2 for x in lazy_tensors[:4]] + lazy_tensors[4:]
+    fetched = get_counter("TransferFromServerBytes")
+    cpu_tensors = lm._maybe_convert_to_cpu(lazy_tensors)
+    assert get_counter("TransferFromServerBytes") - fetched == 8 * 16 * 16 * 4 + 100 * 8
+    assert metrics.metric_data("TransferFromServerThroughput") is not None
+    for i, (x, x_cpu) in enumerate(zip(tensors, cpu_tensors)):
+        torch.testing.assert_close(x_cpu, x * 2 if i < 4 else x)
+
+
+def test_inflight_steps():
+    # The device is released once a step is scheduled, so the steps queue up to the limit while
+    # each one still consumes the output of the previous one.
+    script = """
+import torch
+import ratex.lazy_tensor_core.core.lazy_model as lm
+import ratex.lazy_tensor_core.debug.metrics as metrics
+w = torch.full((64, 64), 1.0 / 64).to("lazy")
+x = torch.ones(64, 64).to("lazy")
+outputs = []
+for step in range(8):
+    x = x @ w + 1
+    lm.mark_step()
+    outputs.append(x)
+lm.wait_device_ops()
+for step, output in enumerate(outputs):
+    torch.testing.assert_close(output.to("cpu"), torch.full((64, 64), step + 2.0))
+_, _, samples = metrics.metric_data("InflightSteps")
+assert max(value for _, value in samples) <= 3
+_, _, samples = metrics.metric_data("StepOverlapRatio")
+assert all(0 <= value <= 1 for _, value in samples)
+"""
+    env_vars = dict(os.environ, LTC_MAX_INFLIGHT_STEPS="3")
+    subprocess.run([sys.executable, "-c", script], env=env_vars, check=True)
+
+
+def test_device_data_cache():
+    x = torch.ones(4, 4).to("lazy")
+    hits = get_counter("DeviceDataCacheHitExact")
+    for _ in range(3):
+        # The scalar is uploaded once, then found in the cache.
+        y = x * 2.5
+        lm.mark_step()
+    assert get_counter("DeviceDataCacheHitExact") - hits >= 2
+    torch.testing.assert_close(y.to("cpu"), torch.full((4, 4), 2.5))
+
+
+DTYPES = [
+    torch.bool,
+    torch.uint8,
+    torch.int8,
+    torch.int16,
+    torch.int32,
+    torch.int64,
+    torch.float16,
+    torch.bfloat16,
+    torch.float32,
+    torch.float64,
+]
+
+
+def make_tensor(shape, dtype):
+    if dtype == torch.bool:
+        return torch.randint(0, 2, shape).bool()
+    if not dtype.is_floating_point:
+        info = torch.iinfo(dtype)
+        return torch.randint(info.min, info.max, shape, dtype=dtype)
+    return torch.randn(shape).to(dtype)
+
+
+@pytest.mark.parametrize("dtype", DTYPES)
+@pytest.mark.parametrize("shape", [(7, 5), (1024, 1024)])
+def test_dtype_round_trip(dtype, shape):
+    # The large shape is copied by multiple threads.
+    x = make_tensor(shape, dtype)
+    x_lazy = x.to("lazy")
+    assert x_lazy.dtype == dtype
+    torch.testing.assert_close(x_lazy.to("cpu"), x, rtol=0, atol=0)
+    # A transposed source is copied into the device layout.
+    torch.testing.assert_close(x.t().to("lazy").to("cpu"), x.t(), rtol=0, atol=0)
+
+
+@pytest.mark.parametrize("env,dtype", [("LTC_USE_BF16", "bfloat16"), ("LTC_USE_FP16", "float16")])
+def test_float_storage_conversion(env, dtype):
+    # The F32 tensors are stored as 16 bits floating point on the device, so their round trip
+    # goes through the F32 conversion kernels, which must round like PyTorch.
+    script = f"""
+import torch
+import ratex.lazy_tensor_core.core.lazy_model as lm
+specials = torch.tensor([0.0, -0.0, 1e-8, 65504.0, 1e5, float("inf"), float("-inf"), float("nan")])
+x = torch.cat([torch.randn(1 << 20), specials])
+expected = x.to(torch.{dtype}).float()
+torch.testing.assert_close(x.to("lazy").to("cpu"), expected, rtol=0, atol=0, equal_nan=True)
+"""
+    env_vars = dict(os.environ, **{env: "1"})
+    subprocess.run([sys.executable, "-c", script], env=env_vars, check=True)
+
+
+if __name__ == "__main__":
+    pytest.main([__file__])
@@ -9,5 +9,13 @@ namespace ratex {
 namespace env {
 const char* const kEnvDefaultDevice = "RATEX_DEVICE";
 const char* const kEnvDeviceCount = "RATEX_DEVICE_COUNT";
+const char* const kEnvDeviceMemoryCapacity = "RATEX_DEVICE_MEMORY_CAPACITY";
+const char* const kEnvMemoryBudget = "RATEX_MEMORY_BUDGET";
+const char* const kEnvDryRunReport = "RATEX_DRY_RUN_REPORT";
+const char* const kEnvHostStagingPoolSize = "RATEX_HOST_STAGING_POOL_SIZE";
+const char* const kEnvScheduleCollectives = "RATEX_SCHEDULE_COLLECTIVES";
+const char* const kEnvCommBandwidth = "RATEX_COMM_BANDWIDTH";
+const char* const kEnvStreamSchedule = "RATEX_STREAM_SCHEDULE";
+const char* const kEnvVerifyCollectiveSchedule = "RATEX_VERIFY_COLLECTIVE_SCHEDULE";
 }  // namespace env
 }  // namespace ratex
@@ -9,5 +9,13 @@ namespace ratex {
 namespace env {
 extern const char* const kEnvDefaultDevice;
 extern const char* const kEnvDeviceCount;
+extern const char* const kEnvDeviceMemoryCapacity;
+extern const char* const kEnvMemoryBudget;
+extern const char* const kEnvDryRunReport;
+extern const char* const kEnvHostStagingPoolSize;
+extern const char* const kEnvScheduleCollectives;
+extern const char* const kEnvCommBandwidth;
+extern const char* const kEnvStreamSchedule;
+extern const char* const kEnvVerifyCollectiveSchedule;
 }  // namespace env
 }  // namespace ratex
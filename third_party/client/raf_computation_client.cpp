@@ -5,6 +5,8 @@
 
 #include "client/raf_computation_client.h"
 
+#include <unistd.h>
+
 #include <fstream>
 #include <iostream>
 
@@ -16,7 +18,10 @@
 #include "ratex/csrc/utils/file.h"
 #include "env_vars.h"
 
+#include "absl/strings/str_cat.h"
+#include "lazy_tensors/computation_client/multi_wait.h"
 #include "lazy_tensors/computation_client/nnc_computation_client.h"
+#include "lazy_tensors/computation_client/thread_pool.h"
 #include "lazy_tensor_core/csrc/device.h"
 
 #include "tvm/node/serialization.h"
@@ -35,9 +40,124 @@ using namespace torch_lazy_tensors::compiler;
 using namespace torch_lazy_tensors::compiler::raf_backend;
 using namespace raf::value;
 
+DeviceMemoryTracker::DeviceStats::DeviceStats(const std::string& device)
+    : in_use_counter(absl::StrCat("RAFDeviceMemoryInUse:", device)),
+      peak_counter(absl::StrCat("RAFDeviceMemoryPeak:", device)) {
+}
+
+DeviceMemoryTracker* DeviceMemoryTracker::Get() {
+  static DeviceMemoryTracker* tracker = new DeviceMemoryTracker();
+  return tracker;
+}
+
+void DeviceMemoryTracker::Track(const std::string& device, const Value& value) {
+  if (!value.defined()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  UpdateValue(GetStats(device), value, 1);
+}
+
+void DeviceMemoryTracker::Untrack(const std::string& device, const Value& value) {
+  if (!value.defined()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  UpdateValue(GetStats(device), value, -1);
+}
+
+void DeviceMemoryTracker::Reserve(const std::string& device, int64_t nbytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  UpdateBytes(GetStats(device), nbytes);
+}
+
+int64_t DeviceMemoryTracker::RegisterExecutable(const ExecutableInfo& info) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t id = next_executable_id_++;
+  executables_[id] = info;
+  // Constants are tracked by buffer, as identical constants of different executables share one.
+  for (const auto& constant : info.constants) {
+    UpdateValue(GetStats(info.device), constant, 1);
+  }
+  return id;
+}
+
+void DeviceMemoryTracker::UnregisterExecutable(int64_t id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = executables_.find(id);
+  LTC_CHECK(it != executables_.end()) << "Unknown executable " << id;
+  for (const auto& constant : it->second.constants) {
+    UpdateValue(GetStats(it->second.device), constant, -1);
+  }
+  executables_.erase(it);
+}
+
+int64_t DeviceMemoryTracker::BytesInUse(const std::string& device) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetStats(device)->bytes_in_use;
+}
+
+int64_t DeviceMemoryTracker::PeakBytes(const std::string& device) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetStats(device)->peak_bytes;
+}
+
+std::map<int64_t, DeviceMemoryTracker::ExecutableInfo> DeviceMemoryTracker::GetExecutables() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return executables_;
+}
+
+DeviceMemoryTracker::DeviceStats* DeviceMemoryTracker::GetStats(const std::string& device) {
+  auto it = stats_.find(device);
+  if (it == stats_.end()) {
+    it = stats_.emplace(device, std::make_unique<DeviceStats>(device)).first;
+  }
+  return it->second.get();
+}
+
+void DeviceMemoryTracker::UpdateValue(DeviceStats* stats, const Value& value, int64_t refs) {
+  if (const auto* tup = value.as<TupleValueObj>()) {
+    for (const auto& field : tup->fields) {
+      UpdateValue(stats, field, refs);
+    }
+  } else if (const auto* tensor = value.as<TensorValueObj>()) {
+    const DLTensor* dl_tensor = tensor->tensor.operator->();
+    if (dl_tensor->data == nullptr) {
+      return;
+    }
+    const void* key = static_cast<const char*>(dl_tensor->data) + dl_tensor->byte_offset;
+    auto it = stats->buffers.find(key);
+    if (it == stats->buffers.end()) {
+      if (refs < 0) {
+        return;
+      }
+      Buffer buffer;
+      buffer.nbytes = raf::common::shape_utils::BytesCompactTensor(*dl_tensor);
+      it = stats->buffers.emplace(key, buffer).first;
+      UpdateBytes(stats, buffer.nbytes);
+    }
+    it->second.refs += refs;
+    if (it->second.refs <= 0) {
+      UpdateBytes(stats, -it->second.nbytes);
+      stats->buffers.erase(it);
+    }
+  }
+}
+
+void DeviceMemoryTracker::UpdateBytes(DeviceStats* stats, int64_t nbytes) {
+  stats->bytes_in_use += nbytes;
+  stats->in_use_counter.AddValue(nbytes);
+  if (stats->bytes_in_use > stats->peak_bytes) {
+    stats->peak_counter.AddValue(stats->bytes_in_use - stats->peak_bytes);
+    stats->peak_bytes = stats->bytes_in_use;
+  }
+}
+
 void RAFComputationClient::RAFData::Assign(const Data& data) {
   const RAFData& raf_data = dynamic_cast<const RAFData&>(data);
   if (&raf_data != this) {
+    DeviceMemoryTracker::Get()->Track(device(), raf_data.handle);
+    DeviceMemoryTracker::Get()->Untrack(device(), handle);
     handle = raf_data.handle;
   }
 }
@@ -51,115 +171,271 @@ std::unique_ptr<ComputationClient> RAFComputationClient::Create() {
   return std::make_unique<RAFComputationClient>(options);
 }
 
-template <typename NativeT>
-void PopulateRn(lazy_tensors::Literal& literal, lazy_tensors::Span<const NativeT> values) {
-  LTC_CHECK(literal.shape().IsArray());
-  LTC_CHECK_EQ(ShapeUtil::ElementsIn(literal.shape()), values.size());
-  LTC_CHECK_EQ(literal.shape().element_type(), primitive_util::NativeToPrimitiveType<NativeT>());
-  auto data_span = literal.data<NativeT>();
-  std::copy(values.begin(), values.end(), data_span.begin());
+ComputationClient::DataPtr RAFComputationClient::CreateDataPlaceholder(std::string device,
+                                                                       Shape shape) {
+  return std::make_shared<RAFData>(std::move(device), shape);
 }
 
-void PopulateRn(lazy_tensors::Literal& literal, void* buf) {
-  using namespace lazy_tensors;
-  switch (literal.shape().element_type()) {
-    case PrimitiveType::S8:
-      return PopulateRn(literal, Span<const int8_t>(reinterpret_cast<const int8_t*>(buf),
-                                                    literal.value().numel()));
-    case PrimitiveType::S32:
-      return PopulateRn(literal, Span<const int32_t>(reinterpret_cast<const int32_t*>(buf),
-                                                     literal.value().numel()));
-    case PrimitiveType::S64:
-      return PopulateRn(literal, Span<const int64_t>(reinterpret_cast<const int64_t*>(buf),
-                                                     literal.value().numel()));
-    case PrimitiveType::PRED:
-      return PopulateRn(
-          literal, Span<const bool>(reinterpret_cast<const bool*>(buf), literal.value().numel()));
-    case PrimitiveType::U8:
-      return PopulateRn(literal, Span<const uint8_t>(reinterpret_cast<const uint8_t*>(buf),
-                                                     literal.value().numel()));
-    case PrimitiveType::U32:
-      return PopulateRn(literal, Span<const uint32_t>(reinterpret_cast<const uint32_t*>(buf),
-                                                      literal.value().numel()));
-    case PrimitiveType::U64:
-      return PopulateRn(literal, Span<const uint64_t>(reinterpret_cast<const uint64_t*>(buf),
-                                                      literal.value().numel()));
-    case PrimitiveType::F16:
-      return PopulateRn(literal, Span<const at::Half>(reinterpret_cast<const at::Half*>(buf),
-                                                      literal.value().numel()));
-    case PrimitiveType::F32:
-      return PopulateRn(
-          literal, Span<const float>(reinterpret_cast<const float*>(buf), literal.value().numel()));
-    case PrimitiveType::F64:
-      return PopulateRn(literal, Span<const double>(reinterpret_cast<const double*>(buf),
-                                                    literal.value().numel()));
-    case PrimitiveType::BF16:
-      return PopulateRn(literal,
-                        Span<const at::BFloat16>(reinterpret_cast<const at::BFloat16*>(buf),
-                                                 literal.value().numel()));
-    default:
-      LTC_LOG(FATAL) << "NotImplementedError: " << literal.shape().element_type();
+HostStagingPool* HostStagingPool::Get() {
+  static HostStagingPool* pool = new HostStagingPool(
+      lazy_tensors::sys_util::GetEnvInt(ratex::env::kEnvHostStagingPoolSize, 256) * 1048576);
+  return pool;
+}
+
+HostStagingPool::HostStagingPool(int64_t capacity) : capacity_(capacity) {
+}
+
+int64_t HostStagingPool::SizeClass(int64_t nbytes) {
+  int64_t size_class = 4096;
+  while (size_class < nbytes) {
+    size_class <<= 1;
   }
+  return size_class;
 }
 
-ComputationClient::DataPtr RAFComputationClient::CreateDataPlaceholder(std::string device,
-                                                                       Shape shape) {
-  return std::make_shared<RAFData>(std::move(device), shape);
+std::shared_ptr<raf::memory_pool::Memory> HostStagingPool::Acquire(int64_t nbytes) {
+  int64_t size_class = SizeClass(nbytes);
+  std::shared_ptr<raf::memory_pool::Memory> buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = free_buffers_.find(size_class);
+    if (it != free_buffers_.end() && !it->second.empty()) {
+      buffer = std::move(it->second.back());
+      it->second.pop_back();
+      retained_bytes_ -= size_class;
+    }
+  }
+  if (buffer != nullptr) {
+    LTC_COUNTER("HostStagingPoolHit", 1);
+    LTC_COUNTER("HostStagingPoolBytesReused", size_class);
+  } else {
+    LTC_COUNTER("HostStagingPoolMiss", 1);
+    buffer = raf::memory_pool::Memory::Alloc(raf::Device(raf::DevType::kCPU(), 0), size_class);
+  }
+  // The returned handle puts the buffer back to the pool when the last reference is dropped.
+  raf::memory_pool::Memory* memory = buffer.get();
+  return std::shared_ptr<raf::memory_pool::Memory>(
+      memory, [this, buffer = std::move(buffer), size_class](raf::memory_pool::Memory*) mutable {
+        Release(std::move(buffer), size_class);
+      });
 }
 
-std::vector<ComputationClient::DataPtr> RAFComputationClient::TransferToServerInternal(
-    lazy_tensors::Span<const TensorSource> tensors) {
-  std::vector<raf::value::TensorValue> tvs(tensors.size());
-  std::vector<ComputationClient::DataPtr> result;
-  for (const auto& ts : tensors) {
-    raf::DType dtype;
-    std::vector<int64_t> shape;
-    raf::Device dev_cpu(raf::DevType::kCPU(), 0);
+void HostStagingPool::Release(std::shared_ptr<raf::memory_pool::Memory> buffer,
+                              int64_t size_class) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (retained_bytes_ + size_class > capacity_) {
+    // Over the bound: the buffer is freed when it goes out of scope.
+    LTC_COUNTER("HostStagingPoolEvict", 1);
+    return;
+  }
+  retained_bytes_ += size_class;
+  free_buffers_[size_class].push_back(std::move(buffer));
+}
+
+namespace {
+
+/*! \brief Tensors up to this size are staged together with their neighbors in one host buffer. */
+constexpr int64_t kSmallTransferBytes = 64 << 10;
+/*! \brief The maximum size of a group of small tensors staged together. */
+constexpr int64_t kTransferGroupBytes = 1 << 20;
+/*! \brief The alignment of the tensors sharing one host buffer. */
+constexpr int64_t kStagingAlignment = 64;
+
+/*! \brief The RAF shape and data type of a tensor to transfer, and its compact size in bytes. */
+struct TransferLayout {
+  std::vector<int64_t> shape;
+  raf::DType dtype;
+  int64_t nbytes = 0;
+};
+
+TransferLayout GetTransferLayout(const ComputationClient::TensorSource& ts) {
+  TransferLayout layout;
+  std::tie(layout.shape, layout.dtype) = ToRAFShape(ts.shape);
+  TensorValue tv_shape =
+      TensorValue::Assemble(raf::Device(raf::DevType::kCPU(), 0), layout.dtype, layout.shape);
+  layout.nbytes = raf::common::shape_utils::BytesCompactTensor(*(tv_shape.operator DLTensor*()));
+  return layout;
+}
+
+/*!
+ * \brief A host buffer owned outside of RAF (e.g., by a PyTorch tensor), which is kept alive as
+ * long as the tensors assembled over it.
+ */
+struct ForeignMemory : public raf::memory_pool::Memory {
+  ForeignMemory(const raf::Device& dev, const void* buffer, std::shared_ptr<void> owner)
+      : owner(std::move(owner)) {
+    data = const_cast<void*>(buffer);
+    device = dev;
+  }
+
+  std::shared_ptr<void> owner;
+};
+
+/*!
+ * \brief Populate a group of tensors into one host staging buffer and copy each of them to its
+ * device. The handles are written to the same indices in handles.
+ */
+void TransferGroup(lazy_tensors::Span<const ComputationClient::TensorSource> tensors,
+                   const std::vector<TransferLayout>& layouts, const std::vector<size_t>& group,
+                   std::vector<ComputationClient::DataPtr>* handles) {
+  std::vector<int64_t> offsets;
+  int64_t group_bytes = 0;
+  for (size_t index : group) {
+    offsets.push_back(group_bytes);
+    group_bytes += (layouts[index].nbytes + kStagingAlignment - 1) / kStagingAlignment *
+                   kStagingAlignment;
+  }
+  raf::Device dev_cpu(raf::DevType::kCPU(), 0);
+  // The staging buffer goes back to the pool once all the copies complete, i.e., when the last
+  // staging tensor is destroyed at the end of this function.
+  std::shared_ptr<raf::memory_pool::Memory> buffer_cpu;
+  for (size_t i = 0; i < group.size(); ++i) {
+    const auto& ts = tensors[group[i]];
+    const TransferLayout& layout = layouts[group[i]];
     raf::Device dev = ToRAFDevice(ts.device);
-    std::tie(shape, dtype) = ToRAFShape(ts.shape);
-    TensorValue tv_shape = raf::value::TensorValue::Assemble(dev_cpu, dtype, shape);
-    int64_t nbytes = raf::common::shape_utils::BytesCompactTensor(*(tv_shape.operator DLTensor*()));
-    auto buffer_cpu = raf::memory_pool::Memory::Alloc(dev_cpu, nbytes);
-    auto tv_cpu = TensorValue::Assemble(dev_cpu, dtype, shape, {}, buffer_cpu->data, buffer_cpu);
-    ts.populate_fn(ts, buffer_cpu->data, nbytes);
-    auto tv = TensorValue::make(
-        raf::tensor::Tensor(tv_cpu->tensor.CopyTo(dev)));  // memory of tv is allocated by tvm
-    result.push_back(
-        std::make_shared<RAFComputationClient::RAFData>(ts.device, Shape(ts.shape), tv));
+    TensorValue tv;
+    if (dev.device_type() == DevType::kCPU() && ts.data != nullptr) {
+      // The device buffer is the host data itself.
+      LTC_COUNTER("TransferToServerZeroCopy", 1);
+      auto buffer = std::make_shared<ForeignMemory>(dev, ts.data, ts.data_owner);
+      tv = TensorValue::Assemble(dev, layout.dtype, layout.shape, {}, buffer->data, buffer);
+    } else if (dev.device_type() == DevType::kCPU()) {
+      // Host memory is the device memory, so the tensor is populated into its own buffer
+      // without staging.
+      LTC_COUNTER("TransferToServerUnstaged", 1);
+      auto buffer = raf::memory_pool::Memory::Alloc(dev, layout.nbytes);
+      tv = TensorValue::Assemble(dev, layout.dtype, layout.shape, {}, buffer->data, buffer);
+      ts.populate_fn(ts, buffer->data, layout.nbytes);
+    } else {
+      if (buffer_cpu == nullptr) {
+        buffer_cpu = HostStagingPool::Get()->Acquire(group_bytes);
+      }
+      void* data = static_cast<char*>(buffer_cpu->data) + offsets[i];
+      auto tv_cpu =
+          TensorValue::Assemble(dev_cpu, layout.dtype, layout.shape, {}, data, buffer_cpu);
+      ts.populate_fn(ts, data, layout.nbytes);
+      tv = TensorValue::make(
+          raf::tensor::Tensor(tv_cpu->tensor.CopyTo(dev)));  // memory of tv is allocated by tvm
+    }
+    (*handles)[group[i]] =
+        std::make_shared<RAFComputationClient::RAFData>(ts.device, Shape(ts.shape), tv);
   }
-  return result;
 }
 
+}  // namespace
+
 std::vector<ComputationClient::DataPtr> RAFComputationClient::TransferToServer(
     lazy_tensors::Span<const TensorSource> tensors) {
-  // TODO(@hzfan): parallel transfer
-  return TransferToServerInternal(tensors);
+  static metrics::Metric* throughput_metric =
+      new metrics::Metric("TransferToServerThroughput", metrics::MetricFnBytes);
+  int64_t start_ns = lazy_tensors::sys_util::NowNs();
+
+  // Each large tensor is transferred on its own, while small tensors are grouped so that they
+  // share one staging buffer.
+  std::vector<TransferLayout> layouts;
+  std::vector<std::vector<size_t>> groups;
+  int64_t total_bytes = 0;
+  int64_t small_group_bytes = kTransferGroupBytes;
+  size_t small_group = 0;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    layouts.push_back(GetTransferLayout(tensors[i]));
+    int64_t nbytes = layouts.back().nbytes;
+    total_bytes += nbytes;
+    if (nbytes > kSmallTransferBytes) {
+      groups.push_back({i});
+      continue;
+    }
+    if (small_group_bytes + nbytes > kTransferGroupBytes) {
+      small_group = groups.size();
+      groups.emplace_back();
+      small_group_bytes = 0;
+    }
+    groups[small_group].push_back(i);
+    small_group_bytes += nbytes;
+  }
+
+  std::vector<DataPtr> handles(tensors.size());
+  if (groups.size() == 1) {
+    TransferGroup(tensors, layouts, groups.front(), &handles);
+  } else if (!groups.empty()) {
+    // Fan the groups out over the IO threads. Each group writes its own handles, so the
+    // handles keep the order of the tensors.
+    auto mwait = std::make_shared<lazy_tensors::util::MultiWait>(groups.size());
+    for (const auto& group : groups) {
+      auto transfer_fn = [&, group_ptr = &group]() {
+        TransferGroup(tensors, layouts, *group_ptr, &handles);
+      };
+      lazy_tensors::env::ScheduleIoClosure(
+          lazy_tensors::util::MultiWait::Completer(mwait, std::move(transfer_fn)));
+    }
+    mwait->Wait();
+  }
+
+  LTC_COUNTER("TransferToServerGroups", groups.size());
+  LTC_COUNTER("TransferToServerBytes", total_bytes);
+  int64_t elapsed_ns = lazy_tensors::sys_util::NowNs() - start_ns;
+  if (elapsed_ns > 0) {
+    // Bytes per second.
+    throughput_metric->AddSample(static_cast<double>(total_bytes) * 1e9 / elapsed_ns);
+  }
+  return handles;
 }
 
 std::vector<Literal> RAFComputationClient::TransferFromServer(
     lazy_tensors::Span<const DataPtr> handles) {
+  static metrics::Metric* throughput_metric =
+      new metrics::Metric("TransferFromServerThroughput", metrics::MetricFnBytes);
+  int64_t start_ns = lazy_tensors::sys_util::NowNs();
+
+  // Compact tensors in host memory are borrowed by their literals. The others are all copied
+  // into one host arena, over which the literals are views.
+  std::vector<Shape> ltc_shapes;
+  std::vector<int64_t> offsets(handles.size(), -1);
+  int64_t arena_bytes = 0;
+  int64_t total_bytes = 0;
+  for (size_t i = 0; i < handles.size(); ++i) {
+    DLTensor* val = static_cast<RAFData*>(handles[i].get())->handle;
+    ltc_shapes.push_back(ToLTCShape(std::vector<int64_t>(val->shape, val->shape + val->ndim),
+                                    val->dtype));
+    int64_t nbytes = raf::common::shape_utils::BytesCompactTensor(*val);
+    total_bytes += nbytes;
+    if (val->device.device_type != DevType::kCPU() || val->strides != nullptr) {
+      offsets[i] = arena_bytes;
+      arena_bytes += (nbytes + kStagingAlignment - 1) / kStagingAlignment * kStagingAlignment;
+    }
+  }
+  at::Tensor arena;
+  if (arena_bytes > 0) {
+    arena = at::empty({arena_bytes}, at::TensorOptions(at::kByte));
+  }
+
   std::vector<Literal> results;
-  for (const auto& handle : handles) {
-    auto* ptr = static_cast<RAFData*>(handle.get());
+  results.reserve(handles.size());
+  raf::Device dev_cpu(raf::DevType::kCPU(), 0);
+  for (size_t i = 0; i < handles.size(); ++i) {
+    auto* ptr = static_cast<RAFData*>(handles[i].get());
     DLTensor* val = ptr->handle;
     auto shape = std::vector<int64_t>(val->shape, val->shape + val->ndim);
-    Literal res(ToLTCShape(shape, val->dtype));
-
-    // Transfer to CPU if it is on the other device.
-    if (val->device.device_type != DevType::kCPU()) {
-      raf::Device dev_cpu(raf::DevType::kCPU(), 0);
-      TensorValue tv_shape = TensorValue::Assemble(dev_cpu, val->dtype, shape);
-      int64_t nbytes =
-          raf::common::shape_utils::BytesCompactTensor(*(tv_shape.operator DLTensor*()));
-      auto buffer_cpu = memory_pool::Memory::Alloc(dev_cpu, nbytes);
-      auto tv_cpu =
-          TensorValue::Assemble(dev_cpu, val->dtype, shape, {}, buffer_cpu->data, buffer_cpu);
-      tv_cpu->tensor.CopyFrom(val);
-      PopulateRn(res, (tv_cpu.operator DLTensor*())->data);
-    } else {
-      PopulateRn(res, val->data);
+    if (offsets[i] < 0) {
+      // The literal borrows the buffer and keeps the value alive until it is destroyed.
+      LTC_COUNTER("TransferFromServerZeroCopy", 1);
+      void* data = static_cast<char*>(val->data) + val->byte_offset;
+      Value value = ptr->handle;
+      results.push_back(Literal::FromBuffer(ltc_shapes[i], data, [value](void*) {}));
+      continue;
     }
-    results.push_back(res);
+    void* data = static_cast<char*>(arena.data_ptr()) + offsets[i];
+    auto tv_cpu = TensorValue::Assemble(dev_cpu, val->dtype, shape, {}, data);
+    tv_cpu->tensor.CopyFrom(val);
+    results.push_back(
+        Literal::FromBuffer(ltc_shapes[i], data, [arena](void*) {}, /*borrowed=*/false));
+  }
+
+  LTC_COUNTER("TransferFromServerBytes", total_bytes);
+  int64_t elapsed_ns = lazy_tensors::sys_util::NowNs() - start_ns;
+  if (elapsed_ns > 0) {
+    // Bytes per second.
+    throughput_metric->AddSample(static_cast<double>(total_bytes) * 1e9 / elapsed_ns);
   }
   return results;
 }
@@ -170,6 +446,83 @@ bool IsIdentityFunction(Function func) {
   return true;
 }
 
+/*! \brief Parse a RATEX_MEMORY_BUDGET other than "auto", i.e. a number of MBs. */
+int64_t ParseMemoryBudget(const std::string& str) {
+  size_t pos = 0;
+  int64_t memory_budget = -1;
+  try {
+    memory_budget = std::stoll(str, &pos);
+  } catch (const std::exception&) {
+    pos = 0;
+  }
+  LTC_CHECK(pos > 0 && pos == str.size() && memory_budget >= 0)
+      << ratex::env::kEnvMemoryBudget << " must be \"auto\" or a non-negative number of MBs, got \""
+      << str << "\"";
+  return memory_budget;
+}
+
+/*! \brief The cost model of the collectives, assuming a bandwidth of RATEX_COMM_BANDWIDTH. */
+raf::pass::OverlapCostModel CommCostModel() {
+  raf::pass::OverlapCostModel cost_model;
+  // From GB/s to bytes per microsecond.
+  cost_model.comm_bytes_per_us =
+      lazy_tensors::sys_util::GetEnvDouble(ratex::env::kEnvCommBandwidth, 10.0) * 1e3;
+  return cost_model;
+}
+
+/*!
+ * \brief Reorder the collectives of the module to overlap with the computation if
+ * RATEX_SCHEDULE_COLLECTIVES is set, and estimate their exposed time before and after.
+ * \return Whether the collectives are scheduled.
+ */
+bool ScheduleAndEstimateCollectives(IRModule* ir_module, raf::pass::OverlapEstimate* before,
+                                    raf::pass::OverlapEstimate* after) {
+  auto cost_model = CommCostModel();
+  *before = *after = raf::pass::EstimateOverlap(raf::pass::InferType()(*ir_module), cost_model);
+  if (before->num_collectives == 0 ||
+      !lazy_tensors::sys_util::GetEnvBool(ratex::env::kEnvScheduleCollectives, false)) {
+    return false;
+  }
+  LTC_TIMED("RAFScheduleCollectives");
+  *ir_module = raf::pass::InferType()(raf::pass::ScheduleCollectives()(*ir_module));
+  *after = raf::pass::EstimateOverlap(*ir_module, cost_model);
+  return true;
+}
+
+/*!
+ * \brief Check that the module optimized by the VM compiler, which may reorder the bindings
+ * again (e.g., the memory scheduling), still issues the collectives as scheduled, and use its
+ * estimate as the scheduled one.
+ */
+void VerifyCollectiveSchedule(const IRModule& optimized, raf::pass::OverlapEstimate* after) {
+  auto lowered = raf::pass::EstimateOverlap(raf::pass::InferType()(optimized), CommCostModel());
+  if (lowered.num_collectives != after->num_collectives) {
+    LTC_LOG(WARNING) << "Found " << lowered.num_collectives << " of the "
+                     << after->num_collectives
+                     << " scheduled collectives in the optimized module, cannot verify the "
+                        "collective schedule";
+    return;
+  }
+  LTC_COUNTER("RAFCollectiveScheduleVerified", 1);
+  if (lowered.num_delayed_collectives > after->num_delayed_collectives) {
+    LTC_COUNTER("RAFCollectiveScheduleLost", 1);
+    LTC_LOG(WARNING) << lowered.num_delayed_collectives - after->num_delayed_collectives
+                     << " collectives are issued later than scheduled in the optimized module";
+  }
+  *after = lowered;
+}
+
+void ReportOverlap(const raf::pass::OverlapEstimate& before,
+                   const raf::pass::OverlapEstimate& after) {
+  static metrics::Metric* before_metric =
+      new metrics::Metric("RAFExposedCommTimeUnscheduled", metrics::MetricFnTime);
+  static metrics::Metric* after_metric =
+      new metrics::Metric("RAFExposedCommTime", metrics::MetricFnTime);
+  // The time metrics are in nanoseconds.
+  before_metric->AddSample(before.exposed_comm_us * 1e3);
+  after_metric->AddSample(after.exposed_comm_us * 1e3);
+}
+
 ComputationClient::ComputationPtr RAFComputationClient::Compile(
     ComputationClient::CompileInstance instance) {
   LTC_TIMED("RAFCompile");
@@ -179,6 +532,9 @@ ComputationClient::ComputationPtr RAFComputationClient::Compile(
   IRModule ir_module = IRModule::FromExpr(computation->computation());
 
   tvm::runtime::Module exe, vm_module;
+  DeviceMemoryTracker::ExecutableInfo memory_info;
+  raf::pass::OverlapEstimate overlap_before, overlap_after;
+  memory_info.device = instance.compilation_device;
   if (!IsIdentityFunction(func)) {
     // For uncached function, we perform the VM compilation and cache the VM.
     // Note that ops in the VM are not JITed until the first execution, but
@@ -223,8 +579,12 @@ ComputationClient::ComputationPtr RAFComputationClient::Compile(
 
     raf::executor::vm::DeviceMap device_map{{Integer((int)(raf_device.device_type())), raf_device}};
 
-    // Rematerialization will be enabled if memory budget > 0.
-    auto memory_budget = lazy_tensors::sys_util::GetEnvInt("RATEX_MEMORY_BUDGET", 0);
+    // Rematerialization will be enabled if memory budget (in MBs) > 0. If it is "auto", the
+    // budget is tuned for each graph to fit the device memory.
+    std::string memory_budget_str =
+        lazy_tensors::sys_util::GetEnvString(ratex::env::kEnvMemoryBudget, "0");
+    bool auto_memory_budget = memory_budget_str == "auto";
+    int64_t memory_budget = auto_memory_budget ? 0 : ParseMemoryBudget(memory_budget_str);
 
     auto pass_ctx = pass::PassContext::Create();
     pass_ctx->opt_level = 3;
@@ -232,6 +592,12 @@ ComputationClient::ComputationPtr RAFComputationClient::Compile(
     pass_ctx->config.Set("raf.memory_schedule", Bool(true));
     pass_ctx->config.Set("raf.memory_budget", Integer(IntImm(DataType::Int(64), memory_budget)));
     pass_ctx->config.Set("raf.remat.use_gflops_cost", Bool(false));
+    // Let the VM run independent operators on separate streams (e.g., "wavefront" or "asap").
+    std::string stream_schedule =
+        lazy_tensors::sys_util::GetEnvString(ratex::env::kEnvStreamSchedule, "");
+    if (!stream_schedule.empty()) {
+      pass_ctx->config.Set("raf.stream_schedule.policy", String(stream_schedule));
+    }
     {
       tvm::With<pass::PassContext> ctx_scope(pass_ctx);
       tvm::With<raf::Device> dev_ctx(raf_device);
@@ -244,8 +610,54 @@ ComputationClient::ComputationPtr RAFComputationClient::Compile(
       if (is_amp_enabled) {
         ir_module = raf::pass::AutoCast()(ir_module);
       }
+      bool scheduled = ScheduleAndEstimateCollectives(&ir_module, &overlap_before, &overlap_after);
+      memory_info.estimate = raf::pass::EstimateMemory(raf::pass::InferType()(ir_module));
+      PostOrderVisit(ir_module->Lookup("main"), [&](const Expr& expr) {
+        if (const auto* constant = expr.as<ConstantNode>()) {
+          if (constant->value.defined()) {
+            memory_info.constants.push_back(Downcast<Value>(constant->value));
+          }
+        }
+      });
+      absl::optional<raf::pass::MemoryEstimate> remat_estimate;
+      if (auto_memory_budget) {
+        memory_budget = TuneMemoryBudget(ir_module, memory_info.estimate,
+                                         instance.compilation_device, &remat_estimate);
+        pass_ctx->config.Set("raf.memory_budget",
+                             Integer(IntImm(DataType::Int(64), memory_budget)));
+      }
+      if (memory_budget > 0) {
+        // Report the footprint and the recompute overhead of the rematerialized graph.
+        if (!remat_estimate) {
+          remat_estimate = raf::pass::EstimateMemory(
+              raf::pass::InferType()(raf::pass::Rematerialization()(ir_module)));
+        }
+        memory_info.memory_budget = memory_budget;
+        memory_info.recompute_ops = remat_estimate->num_calls - memory_info.estimate.num_calls;
+        memory_info.estimate = *remat_estimate;
+        LTC_VALUE_METRIC("RAFRematRecomputeOps", memory_info.recompute_ops);
+      }
+      if (scheduled &&
+          lazy_tensors::sys_util::GetEnvBool(ratex::env::kEnvVerifyCollectiveSchedule, false)) {
+        // Optimizing the module once more doubles its optimization time, so it is only
+        // done to debug the schedule.
+        tvm::runtime::PackedFunc optimize = compiler.GetFunction("optimize", nullptr);
+        if (optimize != nullptr) {
+          IRModule optimized = optimize(ir_module, device_map);
+          VerifyCollectiveSchedule(optimized, &overlap_after);
+        } else {
+          LTC_LOG(WARNING) << "The VM compiler cannot optimize a module on its own, cannot "
+                              "verify the collective schedule";
+        }
+      }
+      if (overlap_before.num_collectives > 0) {
+        ReportOverlap(overlap_before, overlap_after);
+      }
       compiler.Lower(ir_module, device_map);
     }
+    static metrics::Metric* peak_memory_metric =
+        new metrics::Metric("RAFExecutablePeakMemory", metrics::MetricFnBytes);
+    peak_memory_metric->AddSample(memory_info.estimate.peak_bytes);
     exe = compiler.GetFunction("get_executable", nullptr)();
 
     static auto vm_constructor = registry::GetPackedFunc("raf.vm.VirtualMachine");
@@ -254,7 +666,9 @@ ComputationClient::ComputationPtr RAFComputationClient::Compile(
   }
   auto ret = std::make_shared<RAFComputation>(instance.computation,
                                               ConsumeValue(instance.computation->GetProgramShape()),
-                                              instance.devices, exe, vm_module);
+                                              instance.devices, exe, vm_module, memory_info);
+  ret->overlap_before = overlap_before;
+  ret->overlap_after = overlap_after;
   lifted_computation_[ret.get()] = ir_module;
 
   std::string file_path = lazy_tensors::sys_util::GetEnvString("RATEX_SAVE_IR_FILE", "");
@@ -337,6 +751,15 @@ std::vector<ComputationClient::DataPtr> RAFComputationClient::ExecuteComputation
     auto vm_module = raf_computation.vm_module;
     auto* vm = dynamic_cast<raf::executor::vm::VirtualMachine*>(vm_module.operator->());
 
+    // The intermediate tensors of the execution are not owned by any data handle, so the VM
+    // workspace is reserved until the outputs are returned and tracked by their handles.
+    int64_t workspace_bytes = raf_computation.memory_info.estimate.workspace_bytes;
+    DeviceMemoryTracker::Get()->Reserve(device, workspace_bytes);
+    lazy_tensors::util::ExceptionCleanup release_workspace(
+        [&](lazy_tensors::util::ExceptionCleanup::StatusType) {
+          DeviceMemoryTracker::Get()->Reserve(device, -workspace_bytes);
+        });
+
     // Enable auto scheduler when JITing kernels at the first run.
     static auto pass_ctx = pass::PassContext::Create();
     pass_ctx->config.Set("relay.backend.use_auto_scheduler", Bool(true));
@@ -353,6 +776,91 @@ std::vector<ComputationClient::DataPtr> RAFComputationClient::ExecuteComputation
   return explode_tuple(ret);
 }
 
+int64_t RAFComputationClient::TuneMemoryBudget(
+    const IRModule& ir_module, const raf::pass::MemoryEstimate& estimate, const std::string& device,
+    absl::optional<raf::pass::MemoryEstimate>* remat_estimate) {
+  LTC_TIMED("RAFTuneMemoryBudget");
+  constexpr int64_t kMB = 1 << 20;
+  int64_t capacity_mb = GetMemoryInfo(device).kb_total / 1024;
+  if (capacity_mb <= 0) {
+    LTC_LOG(WARNING) << "The memory capacity of " << device << " is unknown, please set "
+                     << ratex::env::kEnvDeviceMemoryCapacity << " to tune the memory budget";
+    return 0;
+  }
+  if (estimate.peak_bytes <= capacity_mb * kMB) {
+    return 0;
+  }
+
+  static auto query = registry::GetPackedFunc("ratex.utils.cache.query");
+  static auto create_entry = registry::GetPackedFunc("ratex.utils.cache.create_entry");
+  Array<ObjectRef> key({String("memory_budget"),
+                        String(std::to_string(tvm::StructuralHash()(ir_module))),
+                        String(std::to_string(capacity_mb))});
+  std::string dirname = query(key).operator std::string();
+  if (!dirname.empty() && PathExist(dirname + "/memory_budget")) {
+    LTC_COUNTER("RAFMemoryBudgetCacheHit", 1);
+    return std::stoll(Load(dirname + "/memory_budget"));
+  }
+
+  // The estimates of the budgets tried, so that the chosen one is not rematerialized again.
+  std::unordered_map<int64_t, raf::pass::MemoryEstimate> trials;
+  auto fits = [&](int64_t budget) {
+    auto trial_ctx = pass::PassContext::Create();
+    trial_ctx->opt_level = pass::PassContext::Current()->opt_level;
+    trial_ctx->config = pass::PassContext::Current()->config;
+    trial_ctx->config.Set("raf.memory_budget", Integer(IntImm(DataType::Int(64), budget)));
+    tvm::With<pass::PassContext> ctx_scope(trial_ctx);
+    IRModule remat_module = raf::pass::InferType()(raf::pass::Rematerialization()(ir_module));
+    trials[budget] = raf::pass::EstimateMemory(remat_module);
+    return trials[budget].peak_bytes <= capacity_mb * kMB;
+  };
+  // Parameters and constants cannot be rematerialized, so they bound the budget from below. A
+  // larger budget keeps more tensors alive and recomputes less, so the largest one that fits wins.
+  int64_t static_bytes = estimate.param_bytes + estimate.constant_bytes;
+  int64_t lo = std::max<int64_t>((static_bytes + kMB - 1) / kMB, 1);
+  int64_t hi = capacity_mb;
+  if (lo > hi || !fits(lo)) {
+    LTC_LOG(WARNING) << "The graph does not fit the memory of " << device << " ("
+                     << capacity_mb << " MBs) even with rematerialization";
+    lo = std::min(lo, hi);
+  } else {
+    while (lo < hi) {
+      int64_t mid = lo + (hi - lo + 1) / 2;
+      if (fits(mid)) {
+        lo = mid;
+      } else {
+        hi = mid - 1;
+      }
+    }
+  }
+
+  dirname = create_entry(key).operator std::string();
+  if (PathExist(dirname)) {
+    Save(dirname + "/memory_budget", std::to_string(lo));
+  }
+  auto it = trials.find(lo);
+  if (it != trials.end()) {
+    *remat_estimate = it->second;
+  }
+  return lo;
+}
+
+ComputationClient::MemoryInfo RAFComputationClient::GetMemoryInfo(const std::string& device) {
+  MemoryInfo info;
+  // The device capacity (in MBs) can be configured, otherwise it is only known for the host.
+  int64_t capacity_mb =
+      lazy_tensors::sys_util::GetEnvInt(ratex::env::kEnvDeviceMemoryCapacity, 0);
+  if (capacity_mb > 0) {
+    info.kb_total = capacity_mb * 1024;
+  } else if (ToRAFDevice(device).device_type() == DevType::kCPU()) {
+    info.kb_total = sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE) / 1024;
+  }
+  int64_t kb_in_use = DeviceMemoryTracker::Get()->BytesInUse(device) / 1024;
+  info.kb_free = std::max<int64_t>(info.kb_total - kb_in_use, 0);
+  info.kb_peak = DeviceMemoryTracker::Get()->PeakBytes(device) / 1024;
+  return info;
+}
+
 TensorValue MakeZeros(Type ty, std::string device) {
   auto tty = Downcast<TensorType>(ty);
   raf::Device dev_cpu(raf::DevType::kCPU(), 0);
@@ -369,6 +877,91 @@ TensorValue MakeZeros(Type ty, std::string device) {
   return tv;
 }
 
+/*! \brief Quote and escape a string as a JSON string. */
+std::string JsonString(const std::string& str) {
+  std::string ret = "\"";
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        ret += "\\\"";
+        break;
+      case '\\':
+        ret += "\\\\";
+        break;
+      case '\n':
+        ret += "\\n";
+        break;
+      case '\t':
+        ret += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppend(&ret, "\\u", absl::Hex(static_cast<int>(c), absl::kZeroPad4));
+        } else {
+          ret += c;
+        }
+    }
+  }
+  return ret + "\"";
+}
+
+/*!
+ * \brief Append the estimated cost and memory of one dry-run execution to the report, as a JSON
+ * line to <path_prefix>.jsonl and as text to <path_prefix>.txt.
+ */
+void ReportDryrun(const std::string& path_prefix, const IRModule& mod,
+                  const RAFComputationClient::RAFComputation& computation,
+                  const std::string& device) {
+  static std::mutex mutex;
+  // The graphs of one step (e.g., a mark_step and a fetch) are reported as separate executions.
+  static int64_t execution = 0;
+  raf::pass::CostEstimate cost = raf::pass::EstimateCost(raf::pass::InferType()(mod));
+  const raf::pass::MemoryEstimate& memory = computation.memory_info.estimate;
+  static metrics::Metric* flops_metric = new metrics::Metric("RAFDryrunFLOPs");
+  static metrics::Metric* bytes_metric =
+      new metrics::Metric("RAFDryrunBytesMoved", metrics::MetricFnBytes);
+  flops_metric->AddSample(cost.flops);
+  bytes_metric->AddSample(cost.bytes_moved);
+
+  std::string json_ops, text_ops;
+  for (const auto& kv : cost.op_counts) {
+    absl::StrAppend(&json_ops, json_ops.empty() ? "" : ", ", JsonString(kv.first), ": ",
+                    kv.second);
+    absl::StrAppend(&text_ops, "    ", kv.first, ": ", kv.second, "\n");
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::ofstream json_file(path_prefix + ".jsonl", std::ios::app);
+  json_file << "{\"execution\": " << execution << ", \"device\": " << JsonString(device)
+            << ", \"flops\": " << cost.flops << ", \"bytes_moved\": " << cost.bytes_moved
+            << ", \"peak_bytes\": " << memory.peak_bytes
+            << ", \"param_bytes\": " << memory.param_bytes
+            << ", \"constant_bytes\": " << memory.constant_bytes
+            << ", \"workspace_bytes\": " << memory.workspace_bytes
+            << ", \"recompute_ops\": " << computation.memory_info.recompute_ops
+            << ", \"num_collectives\": " << computation.overlap_after.num_collectives
+            << ", \"comm_us\": " << computation.overlap_after.comm_us
+            << ", \"exposed_comm_us\": " << computation.overlap_after.exposed_comm_us
+            << ", \"unscheduled_exposed_comm_us\": "
+            << computation.overlap_before.exposed_comm_us
+            << ", \"op_counts\": {" << json_ops << "}}\n";
+  std::ofstream text_file(path_prefix + ".txt", std::ios::app);
+  text_file << "Execution " << execution << " on " << device << "\n"
+            << "  FLOPs: " << cost.flops << "\n"
+            << "  BytesMoved: " << cost.bytes_moved << "\n"
+            << "  PeakMemory: " << memory.peak_bytes << " (params " << memory.param_bytes
+            << ", constants " << memory.constant_bytes << ", workspace "
+            << memory.workspace_bytes << ")\n"
+            << "  RecomputeOps: " << computation.memory_info.recompute_ops << "\n"
+            << "  Collectives: " << computation.overlap_after.num_collectives << " (comm "
+            << computation.overlap_after.comm_us << " us, exposed "
+            << computation.overlap_after.exposed_comm_us << " us, exposed before scheduling "
+            << computation.overlap_before.exposed_comm_us << " us)\n"
+            << "  OpCounts:\n"
+            << text_ops;
+  ++execution;
+}
+
 std::vector<ComputationClient::DataPtr> RAFComputationClient::DryrunComputation(
     const Computation& computation, lazy_tensors::Span<const DataPtr> arguments,
     const std::string& device, const ExecuteComputationOptions& options) {
@@ -379,6 +972,12 @@ std::vector<ComputationClient::DataPtr> RAFComputationClient::DryrunComputation(
     IRModule mod = lifted_computation_.at(&computation);
     auto func = Downcast<Function>(mod->Lookup("main"));
 
+    std::string report_path =
+        lazy_tensors::sys_util::GetEnvString(ratex::env::kEnvDryRunReport, "");
+    if (!report_path.empty()) {
+      ReportDryrun(report_path, mod, raf_computation, device);
+    }
+
     const auto& type = Downcast<FuncType>(func->checked_type())->ret_type;
     if (const auto* tty = type.as<TupleTypeNode>()) {
       std::vector<ComputationClient::DataPtr> ret;
@@ -4,16 +4,120 @@
  */
 
 #pragma once
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include "absl/types/optional.h"
 #include "client/base_computation_client.h"
 #include "lazy_tensors/computation_client/computation_client.h"
 #include "lazy_tensors/computation_client/client_data.h"
+#include "raf/memory_pool.h"
 #include "raf/value.h"
 #include "raf/ir.h"
+#include "ratex/csrc/pass_ext/pass.h"
 
 namespace ratex {
 
 using namespace lazy_tensors;
 
+/*!
+ * \brief Bookkeeping of the device memory held by the RAF client. Tensor buffers are reference
+ * counted by address, so handles sharing a buffer (e.g., outputs updated in-place) are counted
+ * once. Memory not owned by any handle, such as the constants of compiled executables and the
+ * VM workspace of an in-flight execution, is accounted with Reserve().
+ */
+class DeviceMemoryTracker {
+ public:
+  /*! \brief The memory footprint of a live compiled executable. */
+  struct ExecutableInfo {
+    std::string device;
+    raf::pass::MemoryEstimate estimate;
+    /*! \brief The rematerialization budget in MBs, or 0 if rematerialization is disabled. */
+    int64_t memory_budget = 0;
+    /*! \brief The number of operator calls added by rematerialization. */
+    int64_t recompute_ops = 0;
+    /*! \brief The constant tensors of the executable, which may share buffers with others. */
+    std::vector<raf::value::Value> constants;
+  };
+
+  static DeviceMemoryTracker* Get();
+
+  /*! \brief Add a reference to each tensor buffer in the value. */
+  void Track(const std::string& device, const raf::value::Value& value);
+
+  /*! \brief Drop a reference to each tensor buffer in the value. */
+  void Untrack(const std::string& device, const raf::value::Value& value);
+
+  /*! \brief Account (or release, if negative) the bytes not owned by any data handle. */
+  void Reserve(const std::string& device, int64_t nbytes);
+
+  /*! \brief Record a compiled executable and track its constants. Returns its ID. */
+  int64_t RegisterExecutable(const ExecutableInfo& info);
+
+  void UnregisterExecutable(int64_t id);
+
+  int64_t BytesInUse(const std::string& device);
+
+  int64_t PeakBytes(const std::string& device);
+
+  std::map<int64_t, ExecutableInfo> GetExecutables();
+
+ private:
+  struct Buffer {
+    int64_t nbytes = 0;
+    int64_t refs = 0;
+  };
+
+  struct DeviceStats {
+    explicit DeviceStats(const std::string& device);
+
+    int64_t bytes_in_use = 0;
+    int64_t peak_bytes = 0;
+    std::unordered_map<const void*, Buffer> buffers;
+    metrics::Counter in_use_counter;
+    metrics::Counter peak_counter;
+  };
+
+  // The following methods must be called with mutex_ held.
+  DeviceStats* GetStats(const std::string& device);
+  void UpdateValue(DeviceStats* stats, const raf::value::Value& value, int64_t refs);
+  void UpdateBytes(DeviceStats* stats, int64_t nbytes);
+
+  std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<DeviceStats>> stats_;
+  std::map<int64_t, ExecutableInfo> executables_;
+  int64_t next_executable_id_ = 0;
+};
+
+/*!
+ * \brief A pool of host buffers staging the host-to-device transfers. Buffers are binned by size
+ * class (the next power of two) and go back to the pool when released, so that the input batches
+ * of a training loop reuse the same buffers. The retained bytes are bounded by
+ * RATEX_HOST_STAGING_POOL_SIZE (in MBs).
+ */
+class HostStagingPool {
+ public:
+  static HostStagingPool* Get();
+
+  /*! \brief Get a host buffer of at least nbytes, which is recycled once released. */
+  std::shared_ptr<raf::memory_pool::Memory> Acquire(int64_t nbytes);
+
+ private:
+  explicit HostStagingPool(int64_t capacity);
+
+  void Release(std::shared_ptr<raf::memory_pool::Memory> buffer, int64_t size_class);
+
+  static int64_t SizeClass(int64_t nbytes);
+
+  std::mutex mutex_;
+  /*! \brief The maximum bytes retained by the free buffers. */
+  const int64_t capacity_;
+  int64_t retained_bytes_ = 0;
+  /*! \brief The free buffers by size class. */
+  std::map<int64_t, std::vector<std::shared_ptr<raf::memory_pool::Memory>>> free_buffers_;
+};
+
 class RAFComputationClient : public BaseComputationClient {
  public:
   struct RAFData : public BaseData {
@@ -22,6 +126,11 @@ class RAFComputationClient : public BaseComputationClient {
     }
     RAFData(std::string device, Shape shape, raf::value::Value handle, bool is_param = false)
         : BaseData(std::move(device), GetShapeData(std::move(shape)), is_param), handle(handle) {
+      DeviceMemoryTracker::Get()->Track(this->device(), handle);
+    }
+
+    ~RAFData() override {
+      DeviceMemoryTracker::Get()->Untrack(device(), handle);
     }
 
     int64_t get_handle() const {
@@ -52,14 +161,32 @@ class RAFComputationClient : public BaseComputationClient {
     RAFComputation(std::shared_ptr<GenericComputation> computation, ProgramShape program_shape,
                    std::vector<std::string> devices, tvm::runtime::Module executable,
                    tvm::runtime::Module vm_module,
+                   DeviceMemoryTracker::ExecutableInfo memory_info,
                    const std::unordered_map<int64_t, int64_t>& alias = {})
         : BaseComputation(computation, program_shape, devices, alias),
           executable(executable),
-          vm_module(vm_module) {
+          vm_module(vm_module),
+          memory_info(memory_info),
+          memory_id(executable.defined()
+                        ? DeviceMemoryTracker::Get()->RegisterExecutable(memory_info)
+                        : -1) {
+    }
+
+    ~RAFComputation() override {
+      if (memory_id >= 0) {
+        DeviceMemoryTracker::Get()->UnregisterExecutable(memory_id);
+      }
     }
 
     tvm::runtime::Module executable;
     tvm::runtime::Module vm_module;
+    /*! \brief The estimated peak working set of one execution and the rematerialization report */
+    DeviceMemoryTracker::ExecutableInfo memory_info;
+    /*! \brief The ID of this executable in DeviceMemoryTracker, or -1 if not registered */
+    int64_t memory_id = -1;
+    /*! \brief The estimated overlap of the collectives before and after they are scheduled */
+    raf::pass::OverlapEstimate overlap_before;
+    raf::pass::OverlapEstimate overlap_after;
   };
 
   RAFComputationClient(Options options);
@@ -84,8 +211,25 @@ class RAFComputationClient : public BaseComputationClient {
                                          const std::string& device,
                                          const ExecuteComputationOptions& options);
 
+  MemoryInfo GetMemoryInfo(const std::string& device) override;
+
  private:
-  std::vector<DataPtr> TransferToServerInternal(lazy_tensors::Span<const TensorSource> tensors);
+  /*!
+   * \brief Pick the rematerialization budget (in MBs) of a graph for RATEX_MEMORY_BUDGET=auto.
+   * Rematerialization is disabled (0) if the estimated peak memory already fits the device
+   * capacity. Otherwise, the largest budget whose rematerialized graph fits the capacity is
+   * binary searched, which recomputes the fewest operators. The choice is persisted in the
+   * cache per graph hash and device capacity.
+   * \param ir_module The type-inferred module to be lowered.
+   * \param estimate The memory estimate of the module without rematerialization.
+   * \param device The device to run the module.
+   * \param remat_estimate Set to the memory estimate of the rematerialized module if the search
+   * computed it for the returned budget.
+   * \return The memory budget in MBs.
+   */
+  int64_t TuneMemoryBudget(const raf::ir::IRModule& ir_module,
+                           const raf::pass::MemoryEstimate& estimate, const std::string& device,
+                           absl::optional<raf::pass::MemoryEstimate>* remat_estimate);
 };
 
 lazy_tensors::ComputationClient* RAFGet();